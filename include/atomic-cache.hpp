@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomicassets.hpp>
+
+/**
+ * Per action read-through cache of the atomicassets tables.
+ * Each table is only opened once per scope and keeps its loaded rows until the action ends,
+ * so repeated lookups of the same collection, schema or template are not read again from the atomicassets contract.
+*/
+class AtomicCache {
+   public:
+    // get the collection row
+    atomicassets::collections_t::const_iterator collection(name collection) {
+        return atomicassets::collections.require_find(collection.value, "No collection with this name exists!");
+    }
+
+    // check if the user is in the collection's authorized accounts
+    bool is_authorized(name collection, name user) {
+        auto key = make_pair(collection.value, user.value);
+
+        auto itr = authorizations.find(key);
+        if (itr != authorizations.end()) return itr->second;
+
+        const auto &accs = this->collection(collection)->authorized_accounts;
+        bool authorized = find(accs.begin(), accs.end(), user) != accs.end();
+
+        authorizations[key] = authorized;
+        return authorized;
+    }
+
+    // get schemas of collection
+    atomicassets::schemas_t &schemas(name collection) {
+        return schemas_tables.try_emplace(collection.value, atomicassets::ATOMICASSETS_ACCOUNT, collection.value).first->second;
+    }
+
+    // get templates of collection
+    atomicassets::templates_t &templates(name collection) {
+        return templates_tables.try_emplace(collection.value, atomicassets::ATOMICASSETS_ACCOUNT, collection.value).first->second;
+    }
+
+   private:
+    map<pair<uint64_t, uint64_t>, bool> authorizations;
+    map<uint64_t, atomicassets::schemas_t> schemas_tables;
+    map<uint64_t, atomicassets::templates_t> templates_tables;
+};
@@ -4,6 +4,8 @@ It can be used as a header file for other contracts to access the atomicassets t
 and custom data types.
 */
 
+#pragma once
+
 #include <atomicdata.hpp>
 #include <eosio/asset.hpp>
 #include <eosio/eosio.hpp>
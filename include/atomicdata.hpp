@@ -1,6 +1,7 @@
 #pragma once
 
 #include <eosio/eosio.hpp>
+#include <string_view>
 
 #include "base58.hpp"
 
@@ -474,6 +475,127 @@ ATOMIC_ATTRIBUTE deserialize_attribute(const string &type, vector<const uint8_t>
     }
 }
 
+//Moves the iterator past the attribute without deserializing it
+void skip_attribute(const string &type, vector<const uint8_t>::iterator &itr) {
+    if (type.find("[]", type.length() - 2) == type.length() - 2) {
+        //Type is an array
+        uint64_t array_length = unsignedFromVarintBytes(itr);
+        string base_type = type.substr(0, type.length() - 2);
+
+        for (uint64_t i = 0; i < array_length; i++) {
+            skip_attribute(base_type, itr);
+        }
+        return;
+    }
+
+    if (type == "int8" || type == "int16" || type == "int32" || type == "int64" ||
+        type == "uint8" || type == "uint16" || type == "uint32" || type == "uint64") {
+        while (*itr >= 128) {
+            itr++;
+        }
+        itr++;
+
+    } else if (type == "fixed8" || type == "bool" || type == "byte") {
+        itr += 1;
+    } else if (type == "fixed16") {
+        itr += 2;
+    } else if (type == "fixed32" || type == "float") {
+        itr += 4;
+    } else if (type == "fixed64" || type == "double") {
+        itr += 8;
+
+    } else if (type == "string" || type == "image" || type == "ipfs") {
+        uint64_t length = unsignedFromVarintBytes(itr);
+        itr += length;
+
+    } else {
+        check(false, "No type could be matched - " + type);
+    }
+}
+
+//Checks if the type can be read with deserialize_integer
+bool is_integer_type(const string &type) {
+    return type == "int8" || type == "int16" || type == "int32" || type == "int64" ||
+           type == "uint8" || type == "uint16" || type == "uint32" || type == "uint64" ||
+           type == "fixed8" || type == "fixed16" || type == "fixed32" || type == "fixed64" ||
+           type == "bool" || type == "byte";
+}
+
+//Reads an integer attribute directly from the serialized data, without building an ATOMIC_ATTRIBUTE
+//Unsigned values above 2^63 - 1 are capped to 2^63 - 1
+int64_t deserialize_integer(const string &type, vector<const uint8_t>::iterator &itr) {
+    uint64_t number = 0;
+
+    if (type == "int8" || type == "int16" || type == "int32" || type == "int64") {
+        return zigzagDecode(unsignedFromVarintBytes(itr));
+    } else if (type == "uint8" || type == "uint16" || type == "uint32" || type == "uint64") {
+        number = unsignedFromVarintBytes(itr);
+    } else if (type == "fixed8" || type == "bool" || type == "byte") {
+        number = unsignedFromIntBytes(itr, 1);
+    } else if (type == "fixed16") {
+        number = unsignedFromIntBytes(itr, 2);
+    } else if (type == "fixed32") {
+        number = unsignedFromIntBytes(itr, 4);
+    } else if (type == "fixed64") {
+        number = unsignedFromIntBytes(itr, 8);
+    } else {
+        check(false, "Expected an integer type, but got " + type);
+    }
+
+    return number > (uint64_t)INT64_MAX ? INT64_MAX : (int64_t)number;
+}
+
+//Reads a float or double attribute directly from the serialized data
+double deserialize_floating(const string &type, vector<const uint8_t>::iterator &itr) {
+    if (type == "float") {
+        float value;
+        memcpy(&value, &*itr, 4);
+        itr += 4;
+        return value;
+    }
+
+    check(type == "double", "Expected a float or double, but got " + type);
+
+    double value;
+    memcpy(&value, &*itr, 8);
+    itr += 8;
+    return value;
+}
+
+//Reads a string or image attribute as a view into the serialized data, without copying it
+std::string_view deserialize_string_view(vector<const uint8_t>::iterator &itr) {
+    uint64_t string_length = unsignedFromVarintBytes(itr);
+    std::string_view text(reinterpret_cast<const char *>(&*itr), string_length);
+
+    itr += string_length;
+    return text;
+}
+
+//Finds the position of the requested attributes (by their index in the format) in the serialized data.
+//The attributes that are not requested are skipped and the data is only read until all requested attributes are found.
+//An attribute that is not in the data is positioned at data.end()
+vector<vector<const uint8_t>::iterator> locate(const vector<uint8_t> &data, const vector<FORMAT> &format_lines, const vector<uint64_t> &indexes) {
+    vector<vector<const uint8_t>::iterator> positions(indexes.size(), data.end());
+    size_t found = 0;
+
+    auto itr = data.begin();
+    while (itr != data.end() && found < indexes.size()) {
+        uint64_t index = unsignedFromVarintBytes(itr) - RESERVED;
+        check(index < format_lines.size(), "The serialized data does not match the format");
+
+        for (size_t i = 0; i < indexes.size(); i++) {
+            if (indexes[i] == index) {
+                positions[i] = itr;
+                found++;
+            }
+        }
+
+        skip_attribute(format_lines[index].type, itr);
+    }
+
+    return positions;
+}
+
 vector<uint8_t> serialize(ATTRIBUTE_MAP attr_map, const vector<FORMAT> &format_lines) {
     uint64_t number = 0;
     vector<uint8_t> serialized_data = {};
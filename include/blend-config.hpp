@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomicdata.hpp>
+#include <eosio/crypto.hpp>
+
+// dates and the last use are saved as seconds since this time (2023-01-01), so they need fewer varint bytes
+const int64_t BLEND_EPOCH = 1672531200;
+
+const uint8_t BLEND_CONFIG_VERSION = 1;
+
+// presence bits of the blend config, the unset limits are not saved
+const uint8_t BLEND_CONFIG_MAXUSE = 1 << 0;
+const uint8_t BLEND_CONFIG_MAXUSERUSE = 1 << 1;
+const uint8_t BLEND_CONFIG_COOLDOWN = 1 << 2;
+const uint8_t BLEND_CONFIG_STARTDATE = 1 << 3;
+const uint8_t BLEND_CONFIG_ENDDATE = 1 << 4;
+const uint8_t BLEND_CONFIG_WHITELISTS = 1 << 5;  // flag only, nothing is saved
+const uint8_t BLEND_CONFIG_ROOT = 1 << 6;
+
+/**
+ * Decoded blend config, the unset limits are -1.
+ *
+ * Encoding: version byte, presence bitmap, then the zigzag varint of each set limit in the order of the bits
+ * (the dates are relative to BLEND_EPOCH) and the 32 bytes of the whitelist root if it is set.
+*/
+struct BlendConfig {
+    int32_t maxuse = -1;           // -1 = (global use) infinite use, 0 = disabled
+    int32_t maxuseruse = -1;       // -1 = (user use) infinite use
+    int32_t maxusercooldown = -1;  // -1 = no cooldown
+
+    int32_t startdate = -1;  // -1, start as soon
+    int32_t enddate = -1;    // -1, does not end
+
+    bool enable_whitelists = false;  // on whitelists, even if this is changed, the `blendwhlists` entries will not be changed nor modified
+
+    checksum256 whitelist_root = checksum256();  // merkle root of the whitelist, the blender is required to send a proof if this is set
+
+    vector<uint8_t> encode() const {
+        vector<uint8_t> data = {BLEND_CONFIG_VERSION, 0};
+
+        auto put = [&](uint8_t bit, int64_t value) {
+            data[1] |= bit;
+
+            auto bytes = atomicdata::toVarintBytes(zigzag(value));
+            data.insert(data.end(), bytes.begin(), bytes.end());
+        };
+
+        if (maxuse != -1) put(BLEND_CONFIG_MAXUSE, maxuse);
+        if (maxuseruse != -1) put(BLEND_CONFIG_MAXUSERUSE, maxuseruse);
+        if (maxusercooldown != -1) put(BLEND_CONFIG_COOLDOWN, maxusercooldown);
+        if (startdate != -1) put(BLEND_CONFIG_STARTDATE, startdate - BLEND_EPOCH);
+        if (enddate != -1) put(BLEND_CONFIG_ENDDATE, enddate - BLEND_EPOCH);
+
+        if (enable_whitelists) data[1] |= BLEND_CONFIG_WHITELISTS;
+
+        if (whitelist_root != checksum256()) {
+            data[1] |= BLEND_CONFIG_ROOT;
+
+            auto bytes = whitelist_root.extract_as_byte_array();
+            data.insert(data.end(), bytes.begin(), bytes.end());
+        }
+
+        return data;
+    }
+
+    static BlendConfig decode(const vector<uint8_t> &data) {
+        check(data.size() >= 2 && data[0] == BLEND_CONFIG_VERSION, "Unknown blend config version!");
+
+        BlendConfig config;
+        uint8_t bits = data[1];
+        size_t pos = 2;
+
+        auto get = [&](uint8_t bit, int64_t offset) -> int32_t {
+            if (!(bits & bit)) return -1;
+
+            uint64_t value = 0;
+            uint32_t shift = 0;
+            check(pos < data.size(), "Blend config is truncated!");
+            while (data[pos] >= 128) {
+                check(shift < 63, "Blend config value is too long!");
+                value |= uint64_t(data[pos++] - 128) << shift;
+                shift += 7;
+                check(pos < data.size(), "Blend config is truncated!");
+            }
+            value |= uint64_t(data[pos++]) << shift;
+
+            return int32_t(unzigzag(value) + offset);
+        };
+
+        config.maxuse = get(BLEND_CONFIG_MAXUSE, 0);
+        config.maxuseruse = get(BLEND_CONFIG_MAXUSERUSE, 0);
+        config.maxusercooldown = get(BLEND_CONFIG_COOLDOWN, 0);
+        config.startdate = get(BLEND_CONFIG_STARTDATE, BLEND_EPOCH);
+        config.enddate = get(BLEND_CONFIG_ENDDATE, BLEND_EPOCH);
+
+        config.enable_whitelists = bits & BLEND_CONFIG_WHITELISTS;
+
+        if (bits & BLEND_CONFIG_ROOT) {
+            check(data.size() - pos >= 32, "Blend config is truncated!");
+
+            std::array<uint8_t, 32> bytes;
+            copy(data.begin() + pos, data.begin() + pos + 32, bytes.begin());
+            config.whitelist_root = checksum256(bytes);
+        }
+
+        return config;
+    }
+
+   private:
+    static uint64_t zigzag(int64_t value) {
+        return (uint64_t(value) << 1) ^ uint64_t(value >> 63);
+    }
+
+    static int64_t unzigzag(uint64_t value) {
+        return int64_t(value >> 1) ^ -int64_t(value & 1);
+    }
+};
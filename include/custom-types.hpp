@@ -16,15 +16,36 @@ struct SlotBlendTemplateIngredient {
     vector<uint32_t> templates;
 };
 
+// match modes of the attribute allowed values
+const uint8_t ATTRIB_MATCH_SUBSTRING = 0;  // attribute value includes the allowed value
+const uint8_t ATTRIB_MATCH_EXACT = 1;      // attribute value is the allowed value
+const uint8_t ATTRIB_MATCH_PREFIX = 2;     // attribute value starts with the allowed value
+
 struct SlotBlendAttribValuesIngredient {
     string key;
+    uint8_t match;
     vector<string> allowed_values;
 };
 
+// operations of the numeric attributes
+const uint8_t NUMERIC_IN_SET = 0;   // attribute value is one of the values, use one value for equals
+const uint8_t NUMERIC_RANGE = 1;    // attribute value is between min and max (inclusive)
+const uint8_t NUMERIC_BITMASK = 2;  // attribute value has all the bits of the bitmask, integers only
+
+struct SlotBlendAttribNumericIngredient {
+    string key;
+    uint8_t op;
+    vector<int64_t> values;
+    int64_t min;
+    int64_t max;
+    uint64_t bitmask;
+};
+
 struct SlotBlendAttribIngredient {
     name schema;
     bool require_all_attribs;
     vector<SlotBlendAttribValuesIngredient> attributes;
+    vector<SlotBlendAttribNumericIngredient> numeric_attributes;
 };
 
 typedef std::variant<SlotBlendSchemaIngredient, SlotBlendTemplateIngredient, SlotBlendAttribIngredient> SlotBlendIngredientProps;
@@ -36,6 +57,86 @@ struct SlotBlendIngredient {
     SlotBlendIngredientProps props;
 };
 
+/**
+ * Slot ingredients saved before the match modes and the numeric attributes.
+ * - Deprecated, only kept for `migslotblend`. The allowed values were matched as substrings.
+*/
+struct OldSlotBlendAttribValuesIngredient {
+    string key;
+    vector<string> allowed_values;
+};
+
+struct OldSlotBlendAttribIngredient {
+    name schema;
+    bool require_all_attribs;
+    vector<OldSlotBlendAttribValuesIngredient> attributes;
+};
+
+typedef std::variant<SlotBlendSchemaIngredient, SlotBlendTemplateIngredient, OldSlotBlendAttribIngredient> OldSlotBlendIngredientProps;
+
+struct OldSlotBlendIngredient {
+    uint8_t type;
+    name collection;
+    uint32_t amount;
+    OldSlotBlendIngredientProps props;
+};
+
+/**
+ * Compiled attribute check of a slot.
+*/
+struct SlotPredicateAttrib {
+    uint16_t key;             // index of the attribute in the schema format
+    uint8_t match;            // ATTRIB_MATCH_*
+    vector<uint16_t> values;  // ids of the allowed values in the program's value pool, sorted by their value
+};
+
+/**
+ * Compiled numeric attribute check of a slot.
+*/
+struct SlotPredicateNumeric {
+    uint16_t key;            // index of the attribute in the schema format
+    uint8_t op;              // NUMERIC_*
+    vector<int64_t> values;  // sorted
+    int64_t min;
+    int64_t max;
+    uint64_t bitmask;
+};
+
+/**
+ * Compiled slot, this is created from a `SlotBlendIngredient` when the blend is made.
+*/
+struct SlotPredicate {
+    uint8_t type;  // similar to the index of `SlotBlendIngredientProps`
+    name collection;
+    uint32_t amount;
+
+    name schema;                 // schema and attribute slots
+    vector<uint32_t> templates;  // sorted template ids of template slots and the qualifying templates of attribute slots
+
+    bool require_all_attribs;
+    vector<SlotPredicateAttrib> attributes;
+    vector<SlotPredicateNumeric> numeric_attributes;
+};
+
+/**
+ * Compiled slots of a slot blend.
+*/
+struct SlotProgram {
+    vector<SlotPredicate> slots;
+    vector<string> values;     // interned allowed values of all attribute slots
+    int32_t template_counter;  // templates below this id were already checked for the attribute slots
+};
+
+/**
+ * Asset in the deposit ledger, the asset info is saved when it is transferred.
+*/
+struct DepositAsset {
+    uint64_t asset_id;
+    name collection;
+    name schema;
+    int32_t template_id;
+};
+
 struct MultiTarget {
     uint32_t odds;
     uint32_t templateid;
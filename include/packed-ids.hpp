@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomicdata.hpp>
+
+/**
+ * Sorted list of ids saved as varint deltas.
+ * Asset ids are large but close together, so most ids only need one to three bytes instead of eight.
+ * The ids are decoded while iterating, without allocating.
+*/
+struct PackedIds {
+    vector<uint8_t> data;
+
+    class const_iterator {
+       public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = uint64_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const uint64_t *;
+        using reference = const uint64_t &;
+
+        const_iterator(const uint8_t *pos, const uint8_t *end) : pos(pos), next(pos), end(end) {
+            read();
+        }
+
+        reference operator*() const { return value; }
+
+        const_iterator &operator++() {
+            pos = next;
+            read();
+            return *this;
+        }
+
+        bool operator==(const const_iterator &other) const { return pos == other.pos; }
+        bool operator!=(const const_iterator &other) const { return pos != other.pos; }
+
+       private:
+        // decode the delta at the current position and add it to the previous id
+        void read() {
+            if (pos == end) return;
+
+            uint64_t delta = 0;
+            uint32_t shift = 0;
+            while (*next >= 128) {
+                delta |= uint64_t(*next - 128) << shift;
+                shift += 7;
+                next++;
+            }
+            delta |= uint64_t(*next) << shift;
+            next++;
+
+            value += delta;
+        }
+
+        const uint8_t *pos;
+        const uint8_t *next;
+        const uint8_t *end;
+        uint64_t value = 0;
+    };
+
+    const_iterator begin() const { return const_iterator(data.data(), data.data() + data.size()); }
+    const_iterator end() const { return const_iterator(data.data() + data.size(), data.data() + data.size()); }
+
+    // count of ids, each id ends with a byte without the msb
+    size_t size() const {
+        return count_if(data.begin(), data.end(), [](uint8_t b) { return b < 128; });
+    }
+
+    vector<uint64_t> unpack() const {
+        vector<uint64_t> ids = {};
+        ids.reserve(size());
+        ids.insert(ids.end(), begin(), end());
+
+        return ids;
+    }
+
+    static PackedIds pack(vector<uint64_t> ids) {
+        sort(ids.begin(), ids.end());
+
+        PackedIds packed;
+        packed.data.reserve(ids.size() * 3);
+
+        uint64_t previous = 0;
+        for (auto i : ids) {
+            auto bytes = atomicdata::toVarintBytes(i - previous);
+            packed.data.insert(packed.data.end(), bytes.begin(), bytes.end());
+            previous = i;
+        }
+
+        return packed;
+    }
+};
@@ -3,15 +3,21 @@
  *  -> Calling of smart contract is chained.
  *      - Transfer first the NFT to the smart contract.
  *      - Another transaction is needed to process the blending.
+ *  -> Or blend in one transfer.
+ *      - Transfer the NFT with the memo `blend:<type>:<scope>:<blenderid>`, slot blends add `:<claim_id>`.
+ *      - The blend is processed in the transfer notification, nothing is saved for refund.
 */
 #pragma once
 
+#include <atomic-cache.hpp>
 #include <atomicassets.hpp>
+#include <blend-config.hpp>
 #include <custom-types.hpp>
 #include <eosio/crypto.hpp>
 #include <eosio/eosio.hpp>
 #include <eosio/singleton.hpp>
 #include <eosio/transaction.hpp>
+#include <packed-ids.hpp>
 #include <ram-interface.hpp>
 #include <wax-orng.hpp>
 
@@ -19,9 +25,20 @@ using namespace std;
 using namespace eosio;
 
 #define ATOMICASSETS name("atomicassets")
+#define BLEND_PERMISSION name("blend")  // permission of the blender used by the custody-free blends
+
+const string CUSTODYFREE_MEMO = "shomai custody-free blend";
+const string BLEND_MEMO_PREFIX = "blend:";  // memo of transfers that are blended right away
 
 const uint32_t TOTALODDS = 100;
 
+const int64_t ROW_OVERHEAD_BYTES = 112;              // ram billed for each table row, aside from its data
+const int64_t TABLE_OVERHEAD_BYTES = 112;            // ram billed when the first row of a table scope is written
+const int32_t DEPOSIT_EXPIRY = 30 * 24 * 60 * 60;    // deposits are refunded by `sweep` if the ledger was not used for this long
+const int32_t ENDED_BLEND_GRACE = 30 * 24 * 60 * 60;  // blends are removed by `sweep` this long after their end date
+const uint32_t MAX_SWEEP_LIMIT = 100;
+const uint32_t MAX_TEMPLATE_SCAN = 100;  // templates checked per attribute slot when a slot blend is made, `refreshslot` continues the scan
+
 CONTRACT shomaiiblend : public contract {
    public:
     using contract::contract;
@@ -30,20 +47,32 @@ CONTRACT shomaiiblend : public contract {
     ACTION makeblsimple(name author, name collection, uint32_t target, vector<uint32_t> ingredients);
     ACTION makeswsimple(name author, name collection, uint32_t target, uint32_t ingredient);
     ACTION makeblslot(name author, name collection, vector<MultiTarget> targets, vector<SlotBlendIngredient> ingredients, string title);
+    ACTION refreshslot(name author, name scope, uint64_t blenderid, uint32_t limit);
+    ACTION migslotblend(name author, name scope, uint64_t blenderid);
+    ACTION makeblhash(name author, name collection, vector<MultiTarget> targets, vector<SlotBlendIngredient> ingredients);
+    ACTION refreshhash(name author, name scope, uint64_t blenderid, SlotProgram program, uint32_t limit);
+    ACTION logrecipe(uint64_t blenderid, name scope, SlotProgram program);
 
     ACTION remblsimple(name user, name scope, uint64_t blenderid);
     ACTION remswsimple(name user, name scope, uint64_t blenderid);
     ACTION remblslot(name user, name scope, uint64_t blenderid);
+    ACTION remblhash(name user, name scope, uint64_t blenderid);
 
-    ACTION callblsimple(uint64_t blenderid, name blender, name scope, vector<uint64_t> assetids);
-    ACTION callswsimple(uint64_t blenderid, name blender, name scope, uint64_t asset);
-    ACTION callblslot(uint64_t blenderid, name blender, name scope, vector<uint64_t> assetids, uint64_t claim_id);
+    ACTION callblsimple(uint64_t blenderid, name blender, name scope, vector<uint64_t> assetids, vector<checksum256> proof);
+    ACTION callblsmulti(uint64_t blenderid, name blender, name scope, vector<vector<uint64_t>> assetgroups, vector<checksum256> proof);
+    ACTION callswsimple(uint64_t blenderid, name blender, name scope, uint64_t asset, vector<checksum256> proof);
+    ACTION callblslot(uint64_t blenderid, name blender, name scope, vector<uint64_t> assetids, uint64_t claim_id, vector<checksum256> proof);
+    ACTION callblsfree(uint64_t blenderid, name blender, name scope, vector<uint64_t> assetids, vector<checksum256> proof);
+    ACTION callslotfree(uint64_t blenderid, name blender, name scope, vector<uint64_t> assetids, uint64_t claim_id, vector<checksum256> proof);
+    ACTION callblhash(uint64_t blenderid, name blender, name scope, vector<uint64_t> assetids, uint64_t claim_id, SlotProgram program, vector<checksum256> proof);
 
     ACTION claimblslot(uint64_t claim_id, name blender, name scope);
 
     ACTION removeconfig(name author, uint64_t blenderid, name scope);
-    ACTION setwhitelist(name author, uint64_t blenderid, name scope, vector<name> names_list);
+    ACTION addwhlist(name author, uint64_t blenderid, name scope, vector<name> names_list);
+    ACTION remwhlist(name author, uint64_t blenderid, name scope, vector<name> names_list);
     ACTION setonwhlist(name author, uint64_t blenderid, name scope, bool on_whitelist);
+    ACTION setwhroot(name author, uint64_t blenderid, name scope, checksum256 root);
     ACTION setdates(name author, uint64_t blenderid, name scope, int32_t startdate, int32_t enddate);
     ACTION setmax(name author, uint64_t blenderid, name scope, int32_t maxuse, int32_t maxuseruse, int32_t maxusercooldown);
     /* End Blend Actions */
@@ -54,9 +83,10 @@ CONTRACT shomaiiblend : public contract {
 
     /*  Start System actions */
     ACTION init();
-    ACTION initsys();
+    ACTION sysmigrate();
     ACTION sysaddwhite(name collection);
     ACTION sysaddblack(name collection);
+    ACTION setstrictdep(name author, name collection, bool strict);
     /*  End System actions */
 
     /*  Start Ram actions */
@@ -65,7 +95,9 @@ CONTRACT shomaiiblend : public contract {
 
     /* Start Util actions */
     ACTION refundnfts(name user, name scope, vector<uint64_t> assetids);
+    ACTION migrefunds(name user, uint64_t cursor, uint32_t limit);
     ACTION buyramproxy(name collection, asset quantity);
+    ACTION sweep(name table, name scope, name collection, uint64_t cursor, uint32_t limit);
     /* End Util actions */
 
     /* Start Payable Actions */
@@ -84,17 +116,55 @@ CONTRACT shomaiiblend : public contract {
         uint64_t primary_key() const { return collection.value; };
     };
 
+    /**
+     * Service registry of collections.
+    */
+    TABLE service_s {
+        name collection;
+        bool whitelisted;
+        bool blacklisted;
+        bool strict_deposits;  // reject transferred assets that are not from the collection
+
+        uint64_t primary_key() const { return collection.value; };
+    };
+
     /**
      * System configuration singleton table.
+     * - Deprecated, replaced by the `services` table. This is only kept for `sysmigrate`.
     */
     TABLE sysconfig_s {
         vector<name> whitelists;
         vector<name> blacklists;
     };
 
+    /**
+     * Deposit ledger, scoped by the user.
+     * - This is where the NFTs transferred by the user for a collection's blends are logged, these can be refunded if not blended.
+     * - The ledgers are paid by the smart contract, the memo collection is not trusted so nothing is charged to it.
+    */
+    TABLE deposit_s {
+        name collection;
+        vector<DepositAsset> assets;  // sorted by asset id
+
+        unsigned_int last_deposit;  // seconds since BLEND_EPOCH, the ledger can be swept DEPOSIT_EXPIRY after this
+
+        uint64_t primary_key() const { return collection.value; };
+    };
+
+    /**
+     * Assets taken by a custody-free blend, saved until its transfer is received.
+     * Transfers with the custody-free memo are only accepted if they match this row.
+    */
+    TABLE pendingtake_s {
+        name owner;
+        vector<uint64_t> assets;
+
+        uint64_t primary_key() const { return owner.value; };
+    };
+
     /**
      * Refund NFT Table.
-     * - This is where NFT transactions are logged for refund if there are failed transactions.
+     * - Deprecated, replaced by the `deposits` table. This is only kept for `migrefunds`.
     */
     TABLE nftrefund_s {
         uint64_t assetid;
@@ -140,13 +210,45 @@ CONTRACT shomaiiblend : public contract {
         name author;
 
         name collection;
-        vector<SlotBlendIngredient> ingredients;
+        uint64_t specid;  // ingredients in the `slotspecs` table
+        uint64_t poolid;  // targets in the `targetspecs` table
+
+        string title;
+
+        uint64_t primary_key() const { return blenderid; };
+    };
+
+    /**
+     * Slot Blend saved with its ingredients.
+     * - Deprecated, replaced by the `slotblends` table. The rows are moved by the author with `migslotblend`.
+    */
+    TABLE oldslotblend_s {
+        uint64_t blenderid;
+        name author;
+
+        name collection;
+        vector<OldSlotBlendIngredient> ingredients;
 
         string title;
 
         uint64_t primary_key() const { return blenderid; };
     };
 
+    /**
+     * Slot Blend that only keeps the hash of its compiled recipe, so the row has the same size for any recipe.
+     * The recipe is logged by `logrecipe` when the blend is made or refreshed, and callers pass it back when calling.
+    */
+    TABLE hashblend_s {
+        uint64_t blenderid;
+        name author;
+
+        name collection;
+        checksum256 recipe;  // sha256 of the packed program
+        uint64_t poolid;     // targets in the `targetspecs` table
+
+        uint64_t primary_key() const { return blenderid; };
+    };
+
     /**
      * Simple Swap (swap assets, single collection)
     */
@@ -162,8 +264,38 @@ CONTRACT shomaiiblend : public contract {
         // uint64_t by_collection() const { return collection.value; };
     };
 
+    /**
+     * Slot ingredients, shared by the slot blends of the collection that have the same ingredients.
+     * The row is keyed by the content hash and is removed when no blend uses it anymore.
+    */
+    TABLE slotspec_s {
+        uint64_t specid;   // first 8 bytes of the hash
+        checksum256 hash;  // sha256 of the packed ingredients
+        uint32_t refs;     // count of blends using the spec
+
+        vector<SlotBlendIngredient> ingredients;
+        SlotProgram program;  // compiled ingredients, used when calling the blend
+
+        uint64_t primary_key() const { return specid; };
+    };
+
+    /**
+     * Target pool, shared by the slot blends of the collection that have the same targets.
+     * Pending claim jobs also hold a reference, so the pool stays until the random target is picked.
+    */
+    TABLE targetspec_s {
+        uint64_t poolid;   // first 8 bytes of the hash
+        checksum256 hash;  // sha256 of the packed targets
+        uint32_t refs;     // count of blends and pending claim jobs using the pool
+
+        vector<MultiTarget> targets;
+
+        uint64_t primary_key() const { return poolid; };
+    };
+
     /**
      * Multi Target pool.
+     * - Deprecated, replaced by the `targetspecs` table. This is only kept for the claim jobs and the slot blends saved before it.
     */
     TABLE multitarget_s {
         uint64_t blenderid;
@@ -183,6 +315,23 @@ CONTRACT shomaiiblend : public contract {
         uint64_t blenderid;
         name blender;
 
+        int32_t templateid;
+        PackedIds assets;  // ingredients
+
+        bool charged;  // the claim was charged to the collection with its job, claims of the moved jobs were not
+
+        uint64_t primary_key() const { return claim_id; };
+    };
+
+    /**
+     * Deprecated, replaced by the `pclaimassets` table. The rows are moved when claimed.
+    */
+    TABLE oldclaimassets_s {
+        uint64_t claim_id;
+
+        uint64_t blenderid;
+        name blender;
+
         int32_t templateid;
         vector<uint64_t> assets;
 
@@ -197,50 +346,107 @@ CONTRACT shomaiiblend : public contract {
 
         uint64_t blenderid;
         name blender;
-        name scope;               // collection name
-        vector<uint64_t> assets;  // ingredients
+        name scope;        // collection name
+        uint64_t poolid;   // targets of the blend, referenced until the job is done
+        PackedIds assets;  // ingredients
+
+        uint64_t primary_key() const { return claim_id; };
+    };
+
+    /**
+     * Deprecated, replaced by the `pclaimjobs` table. The rows are moved when the random value is received.
+    */
+    TABLE oldclaimjob_s {
+        uint64_t claim_id;
+
+        uint64_t blenderid;
+        name blender;
+        name scope;
+        vector<uint64_t> assets;
 
         uint64_t primary_key() const { return claim_id; };
     };
 
     /**
-     * BlendConfigs (all blends have similar config) this is scalabale in its own way.
+     * Blend state, the config and the usage counter of the blend in one row.
+     * The row is read once when checking the config and modified once when a blend is used.
+     * It is paid by the smart contract and charged to the collection, so any call can write it.
     */
-    TABLE blendconfig_s {
+    TABLE blendstate_s {
         uint64_t blenderid;
 
-        int32_t maxuse = -1;           // -1 = (global use) infinite use, 0 = disabled
-        int32_t maxuseruse = -1;       // -1 = (user use) infinite use
-        int32_t maxusercooldown = -1;  // -1 = no cooldown
+        vector<uint8_t> config;   // encoded BlendConfig, only the set limits are saved, empty if no config set
+        unsigned_int total_uses;  // uses of the blend
 
-        int32_t startdate = -1;  // -1, start as soon
-        int32_t enddate = -1;    // -1, does not end
+        uint64_t primary_key() const { return blenderid; };
+    };
 
-        vector<name> whitelists = {};    // for whitelisting
-        bool enable_whitelists = false;  // on whitelists, even if this is changed, the `whitelists` field will not be changed nor modified
+    /**
+     * BlendConfigs saved before the blend states.
+     * - Deprecated, replaced by the `blendstates` and `blendwhlists` tables. The config is moved when the blend is first read,
+     *   the row is kept until its whitelisted names are moved by sweeping `blendconfig`.
+    */
+    TABLE oldblendconfig_s {
+        uint64_t blenderid;
+
+        int32_t maxuse;
+        int32_t maxuseruse;
+        int32_t maxusercooldown;
+
+        int32_t startdate;
+        int32_t enddate;
+
+        vector<name> whitelists;
+        bool enable_whitelists;
 
         uint64_t primary_key() const { return blenderid; };
     };
 
+    /**
+     * Blend stats saved before the blend states.
+     * - Deprecated, replaced by the `blendstates` table. The rows are moved when the blend is first read.
+    */
+    TABLE oldblendstats_s {
+        uint64_t blenderid;
+        uint32_t total_uses;
+
+        uint64_t primary_key() const { return blenderid; };
+    };
+
+    /**
+     * Blend whitelist. This table is scoped by the blenderid.
+     * The rows are paid by the smart contract and charged to the blend's collection.
+    */
+    TABLE blendwhitelist_s {
+        name user;
+
+        uint64_t primary_key() const { return user.value; };
+    };
+
     /**
      * Blend uses management. This table stores the blend uses per user.
+     * The rows are paid by the smart contract and charged to the blend's collection, so a blend can be called from a transfer.
     */
-    TABLE blendconfiguses_s {
+    TABLE blenduse_s {
         uint64_t blenderid;
+        name collection;  // the collection charged for the row
 
-        name blender;
-        int32_t last_used;
-        int32_t uses;
+        unsigned_int last_used;  // seconds since BLEND_EPOCH, the blender is the scope
+        unsigned_int uses;
 
         uint64_t primary_key() const { return blenderid; };
     };
 
     /**
-     * Blend stats counter on usage.
+     * Blend uses saved before the compact layout.
+     * - Deprecated, replaced by the `blenduses` table. The row is moved when the user calls the blend.
     */
-    TABLE blendstats_s {
+    TABLE oldblendconfiguses_s {
         uint64_t blenderid;
-        uint32_t total_uses;
+
+        name blender;
+        int32_t last_used;
+        int32_t uses;
 
         uint64_t primary_key() const { return blenderid; };
     };
@@ -251,6 +457,7 @@ CONTRACT shomaiiblend : public contract {
     };
 
     typedef multi_index<"rambalances"_n, rambalance_s> rambalance_t;
+    typedef multi_index<"services"_n, service_s> service_t;
 
     typedef singleton<"configs"_n, config_s> config_t;
     typedef multi_index<"configs"_n, config_s> config_t_for_abi;
@@ -259,17 +466,28 @@ CONTRACT shomaiiblend : public contract {
 
     typedef multi_index<"simblenders"_n, simpleblend_s> simblender_t;
     // typedef multi_index<"multblenders"_n, multiblend_s> multiblend_t;
-    typedef multi_index<"slotblenders"_n, slotblend_s> slotblend_t;
+    typedef multi_index<"slotblends"_n, slotblend_s> slotblend_t;
+    typedef multi_index<"slotblenders"_n, oldslotblend_s> oldslotblend_t;
+    typedef multi_index<"hashblends"_n, hashblend_s> hashblend_t;
     typedef multi_index<"simswaps"_n, simpleswap_s> simswap_t;
 
-    typedef multi_index<"blendconfig"_n, blendconfig_s> blendconfig_t;
-    typedef multi_index<"blendcfuses"_n, blendconfiguses_s> blendconfiguses_t;
-    typedef multi_index<"blendstats"_n, blendstats_s> blendstats_t;
+    typedef multi_index<"blendstates"_n, blendstate_s> blendstate_t;
+    typedef multi_index<"blendconfig"_n, oldblendconfig_s> oldblendconfig_t;
+    typedef multi_index<"blendstats"_n, oldblendstats_s> oldblendstats_t;
+    typedef multi_index<"blenduses"_n, blenduse_s> blenduse_t;
+    typedef multi_index<"blendcfuses"_n, oldblendconfiguses_s> oldblendconfiguses_t;
+    typedef multi_index<"blendwhlists"_n, blendwhitelist_s> blendwhitelist_t;
     typedef multi_index<"nftrefunds"_n, nftrefund_s> nftrefund_t;
+    typedef multi_index<"deposits"_n, deposit_s> deposit_t;
+    typedef multi_index<"pendingtakes"_n, pendingtake_s> pendingtake_t;
 
     typedef multi_index<"targetpools"_n, multitarget_s> multitargetpool_t;
-    typedef multi_index<"claimassets"_n, claimassets_s> claimassets_t;
-    typedef multi_index<"claimjobs"_n, claimjob_s> claimjob_t;
+    typedef multi_index<"slotspecs"_n, slotspec_s> slotspec_t;
+    typedef multi_index<"targetspecs"_n, targetspec_s> targetspec_t;
+    typedef multi_index<"pclaimassets"_n, claimassets_s> claimassets_t;
+    typedef multi_index<"pclaimjobs"_n, claimjob_s> claimjob_t;
+    typedef multi_index<"claimassets"_n, oldclaimassets_s> oldclaimassets_t;
+    typedef multi_index<"claimjobs"_n, oldclaimjob_s> oldclaimjob_t;
 
     //  indexed_by<"collection"_n, const_mem_fun<simpleswap_s, uint64_t, &simpleswap_s::by_collection>>
 
@@ -277,7 +495,13 @@ CONTRACT shomaiiblend : public contract {
     config_t config = config_t(_self, _self.value);
     sysconfig_t sysconfig = sysconfig_t(_self, _self.value);
     claimjob_t claimjobs = claimjob_t(_self, _self.value);
+    oldclaimjob_t oldclaimjobs = oldclaimjob_t(_self, _self.value);
     rambalance_t rambalances = rambalance_t(_self, _self.value);
+    service_t services = service_t(_self, _self.value);
+    pendingtake_t pendingtakes = pendingtake_t(_self, _self.value);
+
+    /* Atomicassets tables, cached for the action. */
+    AtomicCache atomiccache;
 
     /* Internal get tables by scope. */
 
@@ -300,19 +524,43 @@ CONTRACT shomaiiblend : public contract {
         return slotblend_t(_self, collection.value);
     }
 
-    // get blendconfigs of collection
-    blendconfig_t get_blendconfigs(name collection) {
-        return blendconfig_t(_self, collection.value);
+    // get slot blends saved before the shared specs
+    oldslotblend_t get_oldslotblends(name collection) {
+        return oldslotblend_t(_self, collection.value);
+    }
+
+    // get hash slotblends of collection
+    hashblend_t get_hashblends(name collection) {
+        return hashblend_t(_self, collection.value);
+    }
+
+    // get blend states of collection
+    blendstate_t get_blendstates(name collection) {
+        return blendstate_t(_self, collection.value);
+    }
+
+    // get blend configs saved before the blend states
+    oldblendconfig_t get_oldblendconfigs(name collection) {
+        return oldblendconfig_t(_self, collection.value);
+    }
+
+    // get blend stats saved before the blend states
+    oldblendstats_t get_oldblendstats(name collection) {
+        return oldblendstats_t(_self, collection.value);
+    }
+
+    // get whitelist of the blend
+    blendwhitelist_t get_blendwhitelists(uint64_t blenderid) {
+        return blendwhitelist_t(_self, blenderid);
     }
 
     // get blenduses of the user
-    blendconfiguses_t get_userblends(name user) {
-        return blendconfiguses_t(_self, user.value);
+    blenduse_t get_userblends(name user) {
+        return blenduse_t(_self, user.value);
     }
 
-    // get blend stats
-    blendstats_t get_blendstats(name collection) {
-        return blendstats_t(_self, collection.value);
+    oldblendconfiguses_t get_olduserblends(name user) {
+        return oldblendconfiguses_t(_self, user.value);
     }
 
     // get nft refunds of collection (use user as scope)
@@ -320,16 +568,36 @@ CONTRACT shomaiiblend : public contract {
         return nftrefund_t(_self, user.value);
     }
 
+    // get deposit ledger of the user
+    deposit_t get_deposits(name user) {
+        return deposit_t(_self, user.value);
+    }
+
     // get multitarget pool
     multitargetpool_t get_blendertargets(name collection) {
         return multitargetpool_t(_self, collection.value);
     }
 
+    // get shared slot ingredients of collection
+    slotspec_t get_slotspecs(name collection) {
+        return slotspec_t(_self, collection.value);
+    }
+
+    // get shared target pools of collection
+    targetspec_t get_targetspecs(name collection) {
+        return targetspec_t(_self, collection.value);
+    }
+
     // get claim assets
     claimassets_t get_claimassets(name collection) {
         return claimassets_t(_self, collection.value);
     }
 
+    // get claim assets saved before the packed ids
+    oldclaimassets_t get_oldclaimassets(name collection) {
+        return oldclaimassets_t(_self, collection.value);
+    }
+
     // get blender id
     uint64_t get_blenderid() {
         // get burner counter
@@ -342,20 +610,146 @@ CONTRACT shomaiiblend : public contract {
 
     atomicassets::collections_t::const_iterator get_collection(name author, name collection);
     atomicassets::templates_t::const_iterator get_target_template(name scope, uint64_t target_template);
-    atomicassets::assets_t::const_iterator validateasset(uint64_t asset, name owner);
+    /**
+     * Assets transferred by the blender, validated once and used until the blend is done.
+    */
+    struct DepositedAssets {
+        deposit_t::const_iterator ledger;  // deposit ledger of the blender in the collection
+        vector<DepositAsset> assets;       // similar order with the asset ids
+    };
+
+    /**
+     * Rows of the blend that are checked and updated by a call, loaded once and used until the blend is done.
+    */
+    struct BlendContext {
+        uint64_t blenderid;
+        name blender;
+        name scope;
+
+        blendstate_t states;
+        blendstate_t::const_iterator state;  // config and total uses of the blend
+        BlendConfig config;                  // default config if the blend has none
+
+        blenduse_t userblends;
+        blenduse_t::const_iterator useruse;  // only loaded if the config has a user limit
+
+        BlendContext(name self, uint64_t blenderid, name blender, name scope)
+            : blenderid(blenderid), blender(blender), scope(scope), states(self, scope.value), userblends(self, blender.value) {
+            load();
+        }
+
+        void load() {
+            state = states.find(blenderid);
+            config = BlendConfig();
+            if (state != states.end() && !state->config.empty()) {
+                config = BlendConfig::decode(state->config);
+            }
+
+            useruse = userblends.end();
+            if (limits_user()) {
+                useruse = userblends.find(blenderid);
+            }
+        }
+
+        bool limits_user() const {
+            return config.maxuseruse != -1 || config.maxusercooldown != -1;
+        }
+    };
+
+    DepositedAssets validateassets(deposit_t & deposits, const vector<uint64_t> &assetids, name collection);
+    vector<DepositAsset> validateownedassets(name owner, const vector<uint64_t> &assetids);
+    void check_assets_collection(const vector<DepositAsset> &assets, name collection);
+    void check_duplicates(vector<uint64_t> assetids);
+
+    // ======== blend functions
+    void blendfrommemo(name blender, const vector<uint64_t> &assetids, const string &memo);
+    uint64_t parse_memo_id(const string &value);
+    void blend_simple(uint64_t blenderid, name blender, name scope, const vector<uint64_t> &assetids, const vector<DepositAsset> &assets, const vector<checksum256> &proof, int64_t table_bytes);
+    void blend_swap(uint64_t blenderid, name blender, name scope, const vector<uint64_t> &assetids, const vector<DepositAsset> &assets, const vector<checksum256> &proof, int64_t table_bytes);
+    void blend_slot(uint64_t blenderid, name blender, name scope, const vector<uint64_t> &assetids, const vector<DepositAsset> &assets, uint64_t claim_id, const vector<checksum256> &proof, int64_t table_bytes);
+    void match_simple_ingredients(const vector<uint32_t> &ingredients, vector<DepositAsset>::const_iterator begin, vector<DepositAsset>::const_iterator end);
+    void match_slot_ingredients(const SlotProgram &program, const vector<DepositAsset> &assets);
+    void finish_slot_blend(BlendContext & context, uint64_t poolid, const vector<uint64_t> &assetids, uint64_t claim_id, int64_t table_bytes);
+    SlotBlendIngredient upgrade_ingredient(const OldSlotBlendIngredient &ingredient);
+
+    // ======== claim functions
+    bool migrateclaimjob(uint64_t claim_id);
+    bool migrateclaimassets(name scope, uint64_t claim_id);
 
     // ======== util functions
     void validate_template_ingredient(atomicassets::templates_t & templates, uint64_t assetid);
     void validate_multitarget(name collection, vector<MultiTarget> targets);
     void validate_caller(name user, name collection);
-
-    void check_config(uint64_t blenderid, name blender, name scope);
-    void remove_blend_config(uint64_t blenderid, name author, name scope);
-    void remove_blend_stats(uint64_t blenderid, name author, name scope);
-    void increment_blend_use(uint64_t blenderid, name blender, name scope);
-    blendconfig_t::const_iterator set_config_check(name author, uint64_t blenderid, name scope);
+    void compile_slot(const SlotBlendIngredient &ingredient, SlotProgram &program);
+    int32_t scan_attrib_templates(SlotPredicate &slot, const vector<string> &values, const vector<FORMAT> &format, int32_t from, int32_t to, uint32_t limit);
+    void refresh_program(SlotProgram &program, uint32_t limit);
+    checksum256 recipe_hash(const SlotProgram &program);
+
+    // ======== shared specs functions
+    uint64_t content_key(const checksum256 &hash);
+    uint64_t acquire_slotspec(name collection, name payer, const vector<SlotBlendIngredient> &ingredients);
+    void release_slotspec(name collection, uint64_t specid);
+    uint64_t acquire_targetspec(name collection, name payer, const vector<MultiTarget> &targets);
+    void retain_targetspec(name collection, uint64_t poolid);
+    void release_targetspec(name collection, uint64_t poolid);
+    bool is_slot_ingredient(const SlotPredicate &slot, const DepositAsset &asset);
+    bool is_attrib_template(const SlotPredicate &slot, const vector<string> &values, const vector<uint8_t> &data, const vector<FORMAT> &format);
+    bool is_allowed_value(const SlotPredicateAttrib &attrib, const vector<string> &values, std::string_view value);
+    bool is_allowed_number(const SlotPredicateNumeric &numeric, const string &type, vector<const uint8_t>::iterator itr);
+
+    void migrate_blend_context(BlendContext & context);
+    bool migrateblendstate(uint64_t blenderid, name scope);
+    bool move_legacy_whitelist(uint64_t blenderid, name scope, uint32_t &limit);
+    bool is_legacy_whitelisted(uint64_t blenderid, name scope, name user);
+    bool migrateblenduse(uint64_t blenderid, name blender, name scope);
+    void check_config(BlendContext & context, const vector<checksum256> &proof, uint32_t uses = 1);
+    bool is_merkle_whitelisted(const checksum256 &root, name user, const vector<checksum256> &proof);
+    void check_blend_scope(uint64_t blenderid, name scope);
+    void remove_blend_state(uint64_t blenderid, name scope);
+    void increment_blend_use(BlendContext & context, uint32_t uses = 1);
+    BlendConfig load_blend_config(const blendstate_t &blendstates, blendstate_t::const_iterator itrState);
+    void save_blend_config(blendstate_t &blendstates, blendstate_t::const_iterator itrState, name scope, uint64_t blenderid, const BlendConfig &blendconfig);
+
+    // ======== sweep functions
+    void sweep_deposits(name user, uint64_t cursor, uint32_t &limit);
+    void sweep_nftrefunds(name user, uint64_t cursor, uint32_t &limit);
+    void sweep_userblends(name user, name collection, uint64_t cursor, uint32_t &limit);
+    void sweep_olduserblends(name user, name collection, uint64_t cursor, uint32_t &limit);
+    void sweep_targetpools(name collection, uint64_t cursor, uint32_t &limit);
+    void sweep_oldblendconfigs(name collection, uint64_t cursor, uint32_t &limit);
+    void sweep_oldblendstats(name collection, uint64_t cursor, uint32_t &limit);
+    template <typename Table, typename Release>
+    void sweep_ended_blends(Table & blends, name scope, uint64_t cursor, uint32_t &limit, Release release);
+    bool sweep_blend_whitelist(uint64_t blenderid, name scope, uint32_t &limit);
+    bool is_blend_ended(name scope, uint64_t blenderid);
+    bool blend_exists(uint64_t blenderid, name scope);
 
     // ram actions
+    template <typename T>
+    int64_t row_bytes(const T &row) {
+        return int64_t(pack_size(row)) + ROW_OVERHEAD_BYTES;
+    }
+    // rows paid by the smart contract for the collection, their ram is charged to the collection's ram balance
+    template <typename Table, typename Lambda>
+    typename Table::const_iterator emplace_charged(Table &table, name collection, Lambda &&constructor) {
+        auto itr = table.emplace(get_self(), std::forward<Lambda>(constructor));
+        charge_ram_balance(collection, row_bytes(*itr));
+        return itr;
+    }
+    template <typename Table, typename Lambda>
+    void modify_charged(Table &table, typename Table::const_iterator itr, name collection, Lambda &&updater) {
+        int64_t before = row_bytes(*itr);
+        table.modify(itr, get_self(), std::forward<Lambda>(updater));
+        charge_ram_balance(collection, row_bytes(*itr) - before);
+    }
+    template <typename Table>
+    typename Table::const_iterator erase_charged(Table &table, typename Table::const_iterator itr, name collection) {
+        int64_t bytes = row_bytes(*itr);
+        itr = table.erase(itr);
+        charge_ram_balance(collection, -bytes);
+        return itr;
+    }
+    void charge_ram_balance(name collection, int64_t bytes);
     void decrease_ram_balance(name collection, int64_t bytes);
     void increase_ram_balance(name collectiom, int64_t bytes);
     void check_ram_balance(name collection);
@@ -363,15 +757,22 @@ CONTRACT shomaiiblend : public contract {
     // ======== sys configs
     bool isWhitelisted(name collection);
     bool isBlacklisted(name collection);
+    void set_service(name collection, bool whitelisted, bool blacklisted);
+    bool isStrictDeposits(name collection);
 
-    void checkfromrefund(uint64_t assetid, name owner);
-    void removeRefundNFTs(name from, name collection, vector<uint64_t> assetids);
+    vector<DepositAsset>::const_iterator findDeposit(const vector<DepositAsset> &assets, uint64_t assetid);
+    void addDeposits(deposit_t & deposits, name collection, vector<DepositAsset> assets);
+    void removeRefundNFTs(deposit_t & deposits, deposit_t::const_iterator ledger, vector<uint64_t> assetids);
+    void removeRefundNFTs(deposit_t & deposits, const DepositedAssets &deposited);
 
     bool isAuthorized(name collection, name user);
 
-    void mintasset(name collection, name schema, uint64_t templateid, name to);
+    void mintasset(name collection, name schema, uint64_t templateid, name to, int64_t table_bytes);
+    int64_t mint_table_bytes(name to, const vector<uint64_t> &taken = {});
     void burnassets(vector<uint64_t> assets);
     void transferassets(vector<uint64_t> assets, name to);
+    void takeassets(name owner, vector<uint64_t> assets);
+    void receivetake(name owner, vector<uint64_t> assets);
 
     /*
   Block the smart contract from calling own functions.
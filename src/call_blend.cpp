@@ -1,17 +1,44 @@
 #include <shomaiiblend.hpp>
 
+#include "slot_matcher.cpp"
+
 /**
  * Call Simple Blend.
 */
-ACTION shomaiiblend::callblsimple(uint64_t blenderid, name blender, name scope, vector<uint64_t> assetids) {
+ACTION shomaiiblend::callblsimple(uint64_t blenderid, name blender, name scope, vector<uint64_t> assetids, vector<checksum256> proof) {
+    require_auth(blender);
+    blockContract(blender);
+
+    // validate the assets once
+    auto deposits = get_deposits(blender);
+    auto deposited = validateassets(deposits, assetids, scope);
+
+    blend_simple(blenderid, blender, scope, assetids, deposited.assets, proof, mint_table_bytes(blender));
+
+    // remove assets from deposits
+    removeRefundNFTs(deposits, deposited);
+}
+
+/**
+ * Call Simple Blend multiple times.
+ * Each group in `assetgroups` is blended into one target. The config, authorization and the target template
+ * are only checked once for all of the groups.
+*/
+ACTION shomaiiblend::callblsmulti(uint64_t blenderid, name blender, name scope, vector<vector<uint64_t>> assetgroups, vector<checksum256> proof) {
     require_auth(blender);
     blockContract(blender);
 
+    check(assetgroups.size() != 0, "Required one or more ingredient groups.");
+
     auto _simpleblends = get_simpleblends(scope);
     auto itr = _simpleblends.require_find(blenderid, "Burner blend does not exist!");
 
-    // check first the blend's config
-    check_config(blenderid, blender, scope);
+    uint32_t uses = uint32_t(assetgroups.size());
+
+    // check first the blend's config, the rows of the blend are only loaded once for the call
+    BlendContext context(get_self(), blenderid, blender, scope);
+    migrate_blend_context(context);
+    check_config(context, proof, uses);
 
     // validate scope
     check(itr->collection == scope, "Scope does not own blender!");
@@ -21,207 +48,352 @@ ACTION shomaiiblend::callblsimple(uint64_t blenderid, name blender, name scope,
 
     auto itrTemplate = get_target_template(scope, uint64_t(itr->target));
 
-    // get id templates of assets
+    // check if the target template can still mint all of the blends
+    check(itrTemplate->max_supply == 0 || itrTemplate->max_supply - itrTemplate->issued_supply >= uses, "Blender cannot mint more assets for the target template id!");
+
+    // sort the ingredients only once
     vector<uint32_t> ingredients = itr->ingredients;
-    vector<uint32_t> blendTemplates = {};
-    auto assets = atomicassets::get_assets(get_self());
-    auto itrAsset = assets.begin();
-    for (size_t i = 0; i < assetids.size(); i++) {
-        itrAsset = assets.find(assetids[i]);
-        blendTemplates.push_back(itrAsset->template_id);
+    sort(ingredients.begin(), ingredients.end());
+
+    vector<uint64_t> assetids = {};
+    for (const auto &group : assetgroups) {
+        check(group.size() == ingredients.size(), "Invalid ingredients!");
+
+        assetids.insert(assetids.end(), group.begin(), group.end());
     }
 
-    // verify if assets match with the ingredients
-    sort(blendTemplates.begin(), blendTemplates.end());
-    sort(ingredients.begin(), ingredients.end());
+    // validate all of the assets once
+    auto deposits = get_deposits(blender);
+    auto deposited = validateassets(deposits, assetids, scope);
 
-    check(blendTemplates == ingredients, "Invalid ingredients!");
+    // verify if assets of each group match with the ingredients
+    for (auto i = deposited.assets.begin(); i != deposited.assets.end(); i += ingredients.size()) {
+        match_simple_ingredients(ingredients, i, i + ingredients.size());
+    }
 
-    // time to blend and burn
-    mintasset(itr->collection, itrTemplate->schema_name, itr->target, blender);
+    // time to blend and burn, the blender's asset table is only created by the first mint
+    int64_t table_bytes = mint_table_bytes(blender);
+    for (uint32_t i = 0; i < uses; i++) {
+        mintasset(itr->collection, itrTemplate->schema_name, itr->target, blender, i == 0 ? table_bytes : 0);
+    }
     burnassets(assetids);
 
-    // remove assets from nftrefunds
-    removeRefundNFTs(blender, scope, assetids);
+    // remove assets from deposits
+    removeRefundNFTs(deposits, deposited);
 
     // increment blend use
-    increment_blend_use(blenderid, blender, scope);
+    increment_blend_use(context, uses);
 }
 
 /**
  * Call Simple Swap
 */
-ACTION shomaiiblend::callswsimple(uint64_t blenderid, name blender, name scope, uint64_t assetid) {
+ACTION shomaiiblend::callswsimple(uint64_t blenderid, name blender, name scope, uint64_t assetid, vector<checksum256> proof) {
     require_auth(blender);
     blockContract(blender);
 
-    auto _simpleswaps = get_simpleswaps(scope);
-    auto itr = _simpleswaps.require_find(blenderid, "Swapper blend does not exist!");
+    // validate the asset
+    vector<uint64_t> assetids = {assetid};
+    auto deposits = get_deposits(blender);
+    auto deposited = validateassets(deposits, assetids, scope);
 
-    // check first the blend's config
-    check_config(blenderid, blender, scope);
+    blend_swap(blenderid, blender, scope, assetids, deposited.assets, proof, mint_table_bytes(blender));
 
-    // validate scope
-    check(itr->collection == scope, "Scope does not own blender!");
-    auto itrCol = atomicassets::collections.require_find(itr->collection.value, "Collection does not exist!");
+    // remove nfts from refund
+    removeRefundNFTs(deposits, deposited);
+}
 
-    // check if the smart contract is authorized in the collection
-    check(isAuthorized(itr->collection, get_self()), "Smart Contract is not authorized for the blend's collection!");
+/**
+ * Call slot blend.
+*/
+ACTION shomaiiblend::callblslot(uint64_t blenderid, name blender, name scope, vector<uint64_t> assetids, uint64_t claim_id, vector<checksum256> proof) {
+    require_auth(blender);
 
-    auto itrTemplate = get_target_template(scope, uint64_t(itr->target));
+    // validate the assets once
+    auto deposits = get_deposits(blender);
+    auto deposited = validateassets(deposits, assetids, scope);
 
-    // get id template of asset
-    auto assets = atomicassets::get_assets(get_self());
-    auto itrSwap = assets.find(assetid);
+    blend_slot(blenderid, blender, scope, assetids, deposited.assets, claim_id, proof, mint_table_bytes(blender));
 
-    check(itrSwap != assets.end(), "Cannot find template ingredient of asset!.");
+    // remove nfts from refund, the assets are now locked in the blend
+    removeRefundNFTs(deposits, deposited);
+}
 
-    // verify if ingredients include the swap template
-    check(itr->ingredient == uint64_t(itrSwap->template_id), "Invalid ingredient for swap!");
+/**
+ * Call hash slot blend.
+ * The caller passes the blend's recipe, which is checked with the saved hash before matching the assets.
+*/
+ACTION shomaiiblend::callblhash(uint64_t blenderid, name blender, name scope, vector<uint64_t> assetids, uint64_t claim_id, SlotProgram program, vector<checksum256> proof) {
+    require_auth(blender);
+    blockContract(blender);
 
-    // time to swap and burn
-    mintasset(itr->collection, itrTemplate->schema_name, itr->target, blender);
-    vector<uint64_t> assetids = {assetid};
+    // check claim_id very first
+    check(claimjobs.find(claim_id) == claimjobs.end() && oldclaimjobs.find(claim_id) == oldclaimjobs.end(), "Generate another unique claim id! Try to refresh and try again.");
 
-    // transfer the assets to the owner of the collection
-    transferassets(assetids, itrCol->author);
+    auto _hashblends = get_hashblends(scope);
+    auto itrBlender = _hashblends.require_find(blenderid, "Slot Blender does not exist!");
 
-    // remove nfts from refund
-    removeRefundNFTs(blender, scope, assetids);
+    // check first the blend's config, the rows of the blend are only loaded once for the call
+    BlendContext context(get_self(), blenderid, blender, scope);
+    migrate_blend_context(context);
+    check_config(context, proof);
 
-    // increment blend use
-    increment_blend_use(blenderid, blender, scope);
+    // the recipe should be the one saved by the blend
+    check(recipe_hash(program) == itrBlender->recipe, "The recipe does not match the blend!");
+
+    // validate the assets once
+    auto deposits = get_deposits(blender);
+    auto deposited = validateassets(deposits, assetids, scope);
+
+    // CHECK ingredients in here
+    match_slot_ingredients(program, deposited.assets);
+
+    // remove nfts from refund, the assets are now locked in the blend
+    removeRefundNFTs(deposits, deposited);
+
+    // mint the target or request for the random target
+    finish_slot_blend(context, itrBlender->poolid, assetids, claim_id, mint_table_bytes(blender));
 }
 
 /**
- * Call slot blend.
+ * Call Simple Blend without transferring the assets first.
+ * The assets are checked in the blender's account and are transferred to the smart contract then burned in this action.
+ * The blender needs a `blend` permission with `shomaiiblend@eosio.code` that is linked to `atomicassets::transfer`.
 */
-ACTION shomaiiblend::callblslot(uint64_t blenderid, name blender, name scope, vector<uint64_t> assetids, uint64_t claim_id) {
+ACTION shomaiiblend::callblsfree(uint64_t blenderid, name blender, name scope, vector<uint64_t> assetids, vector<checksum256> proof) {
     require_auth(blender);
+    blockContract(blender);
 
-    // check claim_id very first
-    check(claimjobs.find(claim_id) == claimjobs.end(), "Generate another unique claim id! Try to refresh and try again.");
+    // validate the assets of the blender
+    auto owned = validateownedassets(blender, assetids);
+    check_assets_collection(owned, scope);
 
-    auto _slotblends = get_slotblends(scope);
-    auto itrBlender = _slotblends.require_find(blenderid, "Slot Blender does not exist!");
+    // the blender's asset table is freed if all of its assets are taken, read it before the take
+    int64_t table_bytes = mint_table_bytes(blender, assetids);
 
-    // check first the blend's config
-    check_config(blenderid, blender, scope);
+    // take the assets first, so they can be burned
+    takeassets(blender, assetids);
 
-    int lastIndex = 0;
+    blend_simple(blenderid, blender, scope, assetids, owned, proof, table_bytes);
+}
 
-    // CHECK ingredients in here
-    for (auto &j : itrBlender->ingredients) {
-        switch (j.props.index()) {
-            case 0: {
-                // check if they have the required schemas
+/**
+ * Call Slot Blend without transferring the assets first.
+ * Similar to `callblsfree`, the assets are checked in the blender's account and transferred in this action.
+*/
+ACTION shomaiiblend::callslotfree(uint64_t blenderid, name blender, name scope, vector<uint64_t> assetids, uint64_t claim_id, vector<checksum256> proof) {
+    require_auth(blender);
+    blockContract(blender);
+
+    // validate the assets of the blender, the slots check their collections
+    auto owned = validateownedassets(blender, assetids);
+
+    // the blender's asset table is freed if all of its assets are taken, read it before the take
+    int64_t table_bytes = mint_table_bytes(blender, assetids);
+
+    // take the assets, these are burned or locked in the claim job
+    takeassets(blender, assetids);
+
+    blend_slot(blenderid, blender, scope, assetids, owned, claim_id, proof, table_bytes);
+}
 
-                auto k = get<SlotBlendSchemaIngredient>(j.props);
+/**
+ * Blends the assets that are already owned by the smart contract with the transfer's memo.
+ * Memo format: `blend:<type>:<scope>:<blenderid>` where type is `simple`, `swap` or `slot`.
+ * Slot blends need the claim id too: `blend:slot:<scope>:<blenderid>:<claim_id>`.
+*/
+void shomaiiblend::blendfrommemo(name blender, const vector<uint64_t> &assetids, const string &memo) {
+    vector<string> args = {};
+    size_t start = 0;
+    for (size_t i = memo.find(':'); i != string::npos; i = memo.find(':', start)) {
+        args.push_back(memo.substr(start, i - start));
+        start = i + 1;
+    }
+    args.push_back(memo.substr(start));
+
+    check(args.size() >= 4, "Invalid blend memo! Expected blend:<type>:<scope>:<blenderid>.");
+
+    const string &type = args[1];
+    name scope = name(args[2]);
+    uint64_t blenderid = parse_memo_id(args[3]);
 
-                for (int i = 0; i < j.amount; i++) {
-                    auto asset = assetids[lastIndex];
-                    auto itr = validateasset(asset, blender);
-                    check(itr->schema_name == k.schema, "The asset ingredient is not from the required slot schema!");
+    // the proof cannot fit in the memo, merkle whitelisted blends should be called with an action
+    vector<checksum256> proof = {};
 
-                    lastIndex++;
-                }
+    // assets are read from the smart contract, these were just transferred
+    auto assets = atomicassets::get_assets(get_self());
+    vector<DepositAsset> received = {};
+    received.reserve(assetids.size());
+    for (auto i : assetids) {
+        auto itr = assets.require_find(i, "Transferred asset does not exist!");
+        received.push_back(DepositAsset{i, itr->collection_name, itr->schema_name, itr->template_id});
+    }
+
+    // the assets were already transferred, so the blender's asset table is read as it is
+    int64_t table_bytes = mint_table_bytes(blender);
+
+    if (type == "simple") {
+        check(args.size() == 4, "Invalid blend memo! Expected blend:simple:<scope>:<blenderid>.");
+        check_assets_collection(received, scope);
+        blend_simple(blenderid, blender, scope, assetids, received, proof, table_bytes);
+    } else if (type == "swap") {
+        check(args.size() == 4, "Invalid blend memo! Expected blend:swap:<scope>:<blenderid>.");
+        check_assets_collection(received, scope);
+        blend_swap(blenderid, blender, scope, assetids, received, proof, table_bytes);
+    } else if (type == "slot") {
+        check(args.size() == 5, "Invalid blend memo! Expected blend:slot:<scope>:<blenderid>:<claim_id>.");
+        blend_slot(blenderid, blender, scope, assetids, received, parse_memo_id(args[4]), proof, table_bytes);
+    } else {
+        check(false, "Invalid blend type in memo!");
+    }
+}
 
-                break;
-            }
-            case 1: {
-                auto k = get<SlotBlendTemplateIngredient>(j.props);
+/**
+ * Parses an id from the memo, only digits are allowed.
+*/
+uint64_t shomaiiblend::parse_memo_id(const string &value) {
+    check(value.size() > 0 && value.size() <= 20, "Invalid id in memo!");
 
-                for (int i = 0; i < j.amount; i++) {
-                    auto asset = assetids[lastIndex];
-                    auto itr = validateasset(asset, blender);
+    uint64_t id = 0;
+    for (auto c : value) {
+        check(c >= '0' && c <= '9', "Invalid id in memo!");
 
-                    bool ok = false;
+        uint64_t digit = uint64_t(c - '0');
+        check(id <= (UINT64_MAX - digit) / 10, "Invalid id in memo!");
+        id = id * 10 + digit;
+    }
 
-                    for (const auto &x : k.templates) {
-                        if (itr->template_id == x) {
-                            ok = true;
+    return id;
+}
 
-                            // stop loop once true
-                            break;
-                        }
-                    }
+/**
+ * Mints the target of the simple blend and burns the ingredients.
+ * The assets should already be owned by the smart contract.
+*/
+void shomaiiblend::blend_simple(uint64_t blenderid, name blender, name scope, const vector<uint64_t> &assetids, const vector<DepositAsset> &assets, const vector<checksum256> &proof, int64_t table_bytes) {
+    auto _simpleblends = get_simpleblends(scope);
+    auto itr = _simpleblends.require_find(blenderid, "Burner blend does not exist!");
 
-                    check(ok, "The asset ingredient does not meet the required templates for blending!");
+    // check first the blend's config, the rows of the blend are only loaded once for the call
+    BlendContext context(get_self(), blenderid, blender, scope);
+    migrate_blend_context(context);
+    check_config(context, proof);
 
-                    lastIndex++;
-                }
+    // validate scope
+    check(itr->collection == scope, "Scope does not own blender!");
+
+    // check if the smart contract is authorized in the collection
+    check(isAuthorized(itr->collection, get_self()), "Smart Contract is not authorized for the blend's collection!");
+
+    auto itrTemplate = get_target_template(scope, uint64_t(itr->target));
+
+    // verify if assets match with the ingredients
+    vector<uint32_t> ingredients = itr->ingredients;
+    sort(ingredients.begin(), ingredients.end());
+    match_simple_ingredients(ingredients, assets.begin(), assets.end());
+
+    // time to blend and burn
+    mintasset(itr->collection, itrTemplate->schema_name, itr->target, blender, table_bytes);
+    burnassets(assetids);
+
+    // increment blend use
+    increment_blend_use(context);
+}
 
-                break;
-            }
-            case 2: {
-                auto k = get<SlotBlendAttribIngredient>(j.props);
+/**
+ * Mints the target of the simple swap and transfers the ingredient to the collection's author.
+ * The asset should already be owned by the smart contract.
+*/
+void shomaiiblend::blend_swap(uint64_t blenderid, name blender, name scope, const vector<uint64_t> &assetids, const vector<DepositAsset> &assets, const vector<checksum256> &proof, int64_t table_bytes) {
+    check(assets.size() == 1, "Only one asset is allowed for swap!");
 
-                auto itrSchemas = atomicassets::get_schemas(j.collection);
-                auto itrTemplates = atomicassets::get_templates(j.collection);
+    auto _simpleswaps = get_simpleswaps(scope);
+    auto itr = _simpleswaps.require_find(blenderid, "Swapper blend does not exist!");
 
-                auto itrSchema = itrSchemas.require_find(k.schema.value, "Schema does not exist in the ingredient's collection!");
+    // check first the blend's config, the rows of the blend are only loaded once for the call
+    BlendContext context(get_self(), blenderid, blender, scope);
+    migrate_blend_context(context);
+    check_config(context, proof);
 
-                for (int i = 0; i < j.amount; i++) {
-                    auto asset = assetids[lastIndex];
-                    auto itr = validateasset(asset, blender);
-                    auto assetTemplate = itrTemplates.find(uint64_t(itr->template_id));
+    // validate scope
+    check(itr->collection == scope, "Scope does not own blender!");
+    auto itrCol = atomiccache.collection(itr->collection);
 
-                    atomicassets::ATTRIBUTE_MAP temp_data = atomicdata::deserialize(assetTemplate->immutable_serialized_data, itrSchema->format);
+    // check if the smart contract is authorized in the collection
+    check(isAuthorized(itr->collection, get_self()), "Smart Contract is not authorized for the blend's collection!");
 
-                    bool ok = false;
+    auto itrTemplate = get_target_template(scope, uint64_t(itr->target));
 
-                    for (const auto &x : k.attributes) {
-                        for (const auto &y : x.allowed_values) {
-                            auto value = get<string>(temp_data[x.key]);
+    // verify if ingredients include the swap template
+    check(itr->ingredient == uint64_t(assets[0].template_id), "Invalid ingredient for swap!");
 
-                            // check if attribute value includes the allowed_value
-                            if (value.find(y) != string::npos) {
-                                ok = true;
+    // time to swap and burn
+    mintasset(itr->collection, itrTemplate->schema_name, itr->target, blender, table_bytes);
 
-                                if (!k.require_all_attribs) {
-                                    break;
-                                }
-                            } else {
-                                ok = false;
-                            }
-                        }
+    // transfer the assets to the owner of the collection
+    transferassets(assetids, itrCol->author);
 
-                        if (ok && !k.require_all_attribs) {
-                            break;
-                        }
-                    }
+    // increment blend use
+    increment_blend_use(context);
+}
 
-                    check(ok, "The asset ingredient does not meet the required schema attributes.");
+/**
+ * Checks the assets with the slots of the slot blend, then mints or requests for the target.
+ * The assets should already be owned by the smart contract.
+*/
+void shomaiiblend::blend_slot(uint64_t blenderid, name blender, name scope, const vector<uint64_t> &assetids, const vector<DepositAsset> &assets, uint64_t claim_id, const vector<checksum256> &proof, int64_t table_bytes) {
+    // check claim_id very first
+    check(claimjobs.find(claim_id) == claimjobs.end() && oldclaimjobs.find(claim_id) == oldclaimjobs.end(), "Generate another unique claim id! Try to refresh and try again.");
 
-                    lastIndex++;
-                }
+    auto _slotblends = get_slotblends(scope);
+    auto itrBlender = _slotblends.find(blenderid);
 
-                break;
-            }
-            default: {
-                check(false, "Invalid ingredient type!");
-            }
-        }
+    if (itrBlender == _slotblends.end()) {
+        auto oldslotblends = get_oldslotblends(scope);
+        check(oldslotblends.find(blenderid) == oldslotblends.end(), "Slot Blender should be migrated by the author with migslotblend!");
+        check(false, "Slot Blender does not exist!");
     }
 
+    // check first the blend's config, the rows of the blend are only loaded once for the call
+    BlendContext context(get_self(), blenderid, blender, scope);
+    migrate_blend_context(context);
+    check_config(context, proof);
+
+    auto slotspecs = get_slotspecs(scope);
+    auto itrSpec = slotspecs.require_find(itrBlender->specid, "Slot spec does not exist!");
+
+    // CHECK ingredients in here
+    match_slot_ingredients(itrSpec->program, assets);
+
+    // mint the target or request for the random target
+    finish_slot_blend(context, itrBlender->poolid, assetids, claim_id, table_bytes);
+}
+
+/**
+ * Mints the target of the slot blend if it only has one, otherwise a claim job is saved and a random value is requested.
+*/
+void shomaiiblend::finish_slot_blend(BlendContext &context, uint64_t poolid, const vector<uint64_t> &assetids, uint64_t claim_id, int64_t table_bytes) {
+    uint64_t blenderid = context.blenderid;
+    name blender = context.blender;
+    name scope = context.scope;
+
     // check if there is only one target
-    auto blender_targets = get_blendertargets(scope);
-    auto itr_blender_targets = blender_targets.require_find(blenderid, "Blender's target pool does not exist.");
+    auto blender_targets = get_targetspecs(scope);
+    auto itr_blender_targets = blender_targets.require_find(poolid, "Blender's target pool does not exist.");
+
+    // increment blend use
+    increment_blend_use(context);
 
     // if only one target, just mint and burn
     if (itr_blender_targets->targets.size() == 1) {
         auto _target = itr_blender_targets->targets[0];
-        auto _templates = atomicassets::get_templates(scope);
 
         auto itr_target = get_target_template(scope, uint64_t(_target.templateid));
 
         // time to swap and burn
-        mintasset(scope, itr_target->schema_name, _target.templateid, blender);
+        mintasset(scope, itr_target->schema_name, _target.templateid, blender, table_bytes);
         burnassets(assetids);
 
-        // remove nfts from refund
-        removeRefundNFTs(blender, scope, assetids);
-
         return;
     }
 
@@ -242,16 +414,24 @@ ACTION shomaiiblend::callblslot(uint64_t blenderid, name blender, name scope, ve
     }
 
     // save job
-    claimjobs.emplace(get_self(), [&](claimjob_s &row) {
+    auto claimjob = claimjobs.emplace(get_self(), [&](claimjob_s &row) {
         row.claim_id = claim_id;
 
         row.blender = blender;
         row.blenderid = blenderid;
         row.scope = scope;
+        row.poolid = poolid;
 
-        row.assets = assetids;
+        row.assets = PackedIds::pack(assetids);
     });
 
+    // the claim saved by `receiverand` is charged now, the randomness callback should not fail on the ram balance
+    claimassets_s claim = {claim_id, blenderid, blender, 0, claimjob->assets, true};
+    charge_ram_balance(scope, row_bytes(*claimjob) + row_bytes(claim));
+
+    // keep the pool until the random target is picked, even if the blend is removed
+    retain_targetspec(scope, poolid);
+
     action(
         permission_level{get_self(), name("active")},
         orng::ORNG_CONTRACT,
@@ -261,7 +441,4 @@ ACTION shomaiiblend::callblslot(uint64_t blenderid, name blender, name scope, ve
             signing_value,
             get_self()))
         .send();
-
-    // increment blend use
-    increment_blend_use(blenderid, blender, scope);
 }
\ No newline at end of file
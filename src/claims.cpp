@@ -7,10 +7,13 @@ ACTION shomaiiblend::receiverand(uint64_t assoc_id, checksum256 random_value) {
 
     RandomnessProvider random_provider(random_value);
 
-    auto claimjob = claimjobs.find(assoc_id);
+    // jobs saved before the packed ids are moved first, these were never charged
+    bool migrated = migrateclaimjob(assoc_id);
 
-    auto targetstable = get_blendertargets(claimjob->scope);
-    auto _target = targetstable.find(claimjob->blenderid);
+    auto claimjob = claimjobs.require_find(assoc_id, "Claim job does not exist!");
+
+    auto targetstable = get_targetspecs(claimjob->scope);
+    auto _target = targetstable.require_find(claimjob->poolid, "Blender's target pool does not exist.");
 
     auto claimassets = get_claimassets(claimjob->scope);
 
@@ -27,22 +30,30 @@ ACTION shomaiiblend::receiverand(uint64_t assoc_id, checksum256 random_value) {
                 row.claim_id = claimjob->claim_id;
                 row.templateid = i.templateid;
                 row.assets = claimjob->assets;
+                row.charged = !migrated;
             });
 
             break;
         }
     }
 
-    // remove the assets if blend has been added to claims
-    removeRefundNFTs(claimjob->blender, claimjob->scope, claimjob->assets);
+    // the job does not need the pool anymore
+    release_targetspec(claimjob->scope, claimjob->poolid);
+
+    // erase the job, its claim was already charged with it
+    name collection = claimjob->scope;
+    int64_t bytes = migrated ? 0 : row_bytes(*claimjob);
 
-    // erase the job
     claimjobs.erase(claimjob);
+    charge_ram_balance(collection, -bytes);
 }
 
 ACTION shomaiiblend::claimblslot(uint64_t claim_id, name blender, name scope) {
     require_auth(blender);
 
+    // claims saved before the packed ids are moved first, these were never charged
+    migrateclaimassets(scope, claim_id);
+
     auto claimassets = get_claimassets(scope);
 
     auto itrClaim = claimassets.require_find(claim_id, "Claim ID does not exist, maybe it was already claimed?");
@@ -51,9 +62,71 @@ ACTION shomaiiblend::claimblslot(uint64_t claim_id, name blender, name scope) {
     // get claim template
     auto itrTemplate = get_target_template(scope, uint64_t(itrClaim->templateid));
 
-    mintasset(scope, itrTemplate->schema_name, itrClaim->templateid, blender);
-    burnassets(itrClaim->assets);
+    mintasset(scope, itrTemplate->schema_name, itrClaim->templateid, blender, mint_table_bytes(blender));
+    burnassets(itrClaim->assets.unpack());
+
+    // remove the claim, only the claims charged with their job are credited back
+    int64_t bytes = itrClaim->charged ? row_bytes(*itrClaim) : 0;
 
-    // remove the claim
     claimassets.erase(itrClaim);
-}
\ No newline at end of file
+    charge_ram_balance(scope, -bytes);
+}
+
+/**
+ * Moves the claim job from the deprecated `claimjobs` table, returns true if it was still there.
+*/
+bool shomaiiblend::migrateclaimjob(uint64_t claim_id) {
+    auto itrOld = oldclaimjobs.find(claim_id);
+    if (itrOld == oldclaimjobs.end()) return false;
+
+    // the targets of the job are moved to the shared pools
+    auto oldtargets = get_blendertargets(itrOld->scope);
+    auto itrTargets = oldtargets.require_find(itrOld->blenderid, "Blender's target pool does not exist.");
+    uint64_t poolid = acquire_targetspec(itrOld->scope, get_self(), itrTargets->targets);
+
+    // the old jobs kept their ingredients in the refund table until the random value, the claim burns them now
+    auto refundtable = get_nftrefunds(itrOld->blender);
+    for (auto i : itrOld->assets) {
+        auto itrRefund = refundtable.find(i);
+        if (itrRefund == refundtable.end()) continue;
+
+        refundtable.erase(itrRefund);
+    }
+
+    claimjobs.emplace(get_self(), [&](claimjob_s &row) {
+        row.claim_id = itrOld->claim_id;
+
+        row.blender = itrOld->blender;
+        row.blenderid = itrOld->blenderid;
+        row.scope = itrOld->scope;
+        row.poolid = poolid;
+
+        row.assets = PackedIds::pack(itrOld->assets);
+    });
+
+    oldclaimjobs.erase(itrOld);
+    return true;
+}
+
+/**
+ * Moves the claim from the deprecated `claimassets` table, returns true if it was still there.
+*/
+bool shomaiiblend::migrateclaimassets(name scope, uint64_t claim_id) {
+    auto oldclaimassets = get_oldclaimassets(scope);
+
+    auto itrOld = oldclaimassets.find(claim_id);
+    if (itrOld == oldclaimassets.end()) return false;
+
+    auto claimassets = get_claimassets(scope);
+    claimassets.emplace(get_self(), [&](claimassets_s &row) {
+        row.blender = itrOld->blender;
+        row.blenderid = itrOld->blenderid;
+        row.claim_id = itrOld->claim_id;
+        row.templateid = itrOld->templateid;
+        row.assets = PackedIds::pack(itrOld->assets);
+        row.charged = false;
+    });
+
+    oldclaimassets.erase(itrOld);
+    return true;
+}
@@ -1,49 +1,183 @@
 #include <shomaiiblend.hpp>
 
 /**
- * Checks and validates the blend config.
+ * Moves the rows saved before the blend states for the call, then loads the context again.
+ * The old tables are only read for a blend without a state or a limited user without a use yet,
+ * the state is written by the first call so the migrated blends do not read them again.
+*/
+void shomaiiblend::migrate_blend_context(BlendContext &context) {
+    if (context.state == context.states.end() && migrateblendstate(context.blenderid, context.scope)) {
+        context.load();
+    }
+
+    if (context.limits_user() && context.useruse == context.userblends.end() && migrateblenduse(context.blenderid, context.blender, context.scope)) {
+        context.load();
+    }
+}
+
+/**
+ * Moves the config and the stats saved before the blend states, returns true if the blend had any.
+ * The new row is paid by the smart contract and charged to the collection, the old stats are erased so their payer gets the ram back.
+ * The old config is kept while it has whitelisted names, these are moved in pages by sweeping `blendconfig`.
+*/
+bool shomaiiblend::migrateblendstate(uint64_t blenderid, name scope) {
+    auto oldconfigs = get_oldblendconfigs(scope);
+    auto oldstats = get_oldblendstats(scope);
+
+    auto itrConfig = oldconfigs.find(blenderid);
+    auto itrStats = oldstats.find(blenderid);
+    if (itrConfig == oldconfigs.end() && itrStats == oldstats.end()) return false;
+
+    // the old rows are moved before the state is read, so the state can only exist if it was written after them
+    auto _blendstates = get_blendstates(scope);
+    if (_blendstates.find(blenderid) == _blendstates.end()) {
+        vector<uint8_t> encoded = {};
+
+        if (itrConfig != oldconfigs.end()) {
+            BlendConfig blendconfig;
+            blendconfig.maxuse = itrConfig->maxuse;
+            blendconfig.maxuseruse = itrConfig->maxuseruse;
+            blendconfig.maxusercooldown = itrConfig->maxusercooldown;
+            blendconfig.startdate = itrConfig->startdate;
+            blendconfig.enddate = itrConfig->enddate;
+            blendconfig.enable_whitelists = itrConfig->enable_whitelists;
+
+            encoded = blendconfig.encode();
+        }
+
+        emplace_charged(_blendstates, scope, [&](blendstate_s &row) {
+            row.blenderid = blenderid;
+            row.config = encoded;
+            row.total_uses = itrStats != oldstats.end() ? itrStats->total_uses : 0;
+        });
+    }
+
+    if (itrConfig != oldconfigs.end() && itrConfig->whitelists.empty()) oldconfigs.erase(itrConfig);
+    if (itrStats != oldstats.end()) oldstats.erase(itrStats);
+
+    return true;
+}
+
+/**
+ * Moves at most `limit` whitelisted names of the old config to the blend's whitelist table, returns true if the old config is gone.
+ * The blend's state should already be moved.
 */
-void shomaiiblend::check_config(uint64_t blenderid, name blender, name scope) {
-    auto _blendconfig = get_blendconfigs(scope);
-    auto itrConfig = _blendconfig.find(blenderid);
+bool shomaiiblend::move_legacy_whitelist(uint64_t blenderid, name scope, uint32_t &limit) {
+    auto oldconfigs = get_oldblendconfigs(scope);
+    auto itrConfig = oldconfigs.find(blenderid);
+    if (itrConfig == oldconfigs.end()) return true;
 
-    // do not check if no config set
-    if (itrConfig == _blendconfig.end()) return;
+    auto _whitelists = get_blendwhitelists(blenderid);
+
+    vector<name> remaining = itrConfig->whitelists;
+    for (; !remaining.empty() && limit > 0; limit--) {
+        name user = remaining.back();
+        remaining.pop_back();
+
+        if (_whitelists.find(user.value) != _whitelists.end()) continue;
+
+        emplace_charged(_whitelists, scope, [&](blendwhitelist_s &row) {
+            row.user = user;
+        });
+    }
+
+    if (remaining.empty()) {
+        oldconfigs.erase(itrConfig);
+        return true;
+    }
+
+    // the moved names are dropped, so the author gets their ram back
+    oldconfigs.modify(itrConfig, same_payer, [&](oldblendconfig_s &row) {
+        row.whitelists = remaining;
+    });
+    return false;
+}
+
+/**
+ * Checks the names of the old config that are not moved yet, only read if the user is not in the whitelist table.
+*/
+bool shomaiiblend::is_legacy_whitelisted(uint64_t blenderid, name scope, name user) {
+    auto oldconfigs = get_oldblendconfigs(scope);
+    auto itrConfig = oldconfigs.find(blenderid);
+    if (itrConfig == oldconfigs.end()) return false;
+
+    return find(itrConfig->whitelists.begin(), itrConfig->whitelists.end(), user) != itrConfig->whitelists.end();
+}
+
+/**
+ * Moves the blend use of the user saved before the compact layout, returns true if the user had one.
+ * The old dates are absolute, the ones before BLEND_EPOCH are saved as BLEND_EPOCH.
+*/
+bool shomaiiblend::migrateblenduse(uint64_t blenderid, name blender, name scope) {
+    auto olduses = get_olduserblends(blender);
+    auto itrOld = olduses.find(blenderid);
+    if (itrOld == olduses.end()) return false;
+
+    auto _blenduses = get_userblends(blender);
+    if (_blenduses.find(blenderid) == _blenduses.end()) {
+        emplace_charged(_blenduses, scope, [&](blenduse_s &row) {
+            row.blenderid = blenderid;
+            row.collection = scope;
+            row.last_used = uint32_t(max(int64_t(itrOld->last_used) - BLEND_EPOCH, int64_t(0)));
+            row.uses = uint32_t(max(itrOld->uses, 0));
+        });
+    }
+
+    olduses.erase(itrOld);
+
+    return true;
+}
+
+/**
+ * Checks and validates the blend config.
+ * The rules are checked with the rows of the context, nothing is read again.
+ * `proof` is the merkle proof of the blender, only used if the blend has a whitelist root.
+ * `uses` is the number of blends that will be done in the call (more than one for batch calls).
+*/
+void shomaiiblend::check_config(BlendContext &context, const vector<checksum256> &proof, uint32_t uses) {
+    const BlendConfig &blendconfig = context.config;
 
     // check the dates
-    if (itrConfig->startdate != -1) {
-        check(now() >= itrConfig->startdate, "Still waiting for start date.");
+    if (blendconfig.startdate != -1) {
+        check(now() >= blendconfig.startdate, "Still waiting for start date.");
     }
-    if (itrConfig->enddate != -1) {
-        check(now() <= itrConfig->enddate, "Blending end date has already passed.");
+    if (blendconfig.enddate != -1) {
+        check(now() <= blendconfig.enddate, "Blending end date has already passed.");
     }
 
     // check the whitelist
-    if (itrConfig->enable_whitelists) {
-        check(find(itrConfig->whitelists.begin(), itrConfig->whitelists.end(), blender) != itrConfig->whitelists.end(), "You are not whitelisted for this blend.");
+    if (blendconfig.enable_whitelists) {
+        auto _whitelists = get_blendwhitelists(context.blenderid);
+        bool whitelisted = _whitelists.find(context.blender.value) != _whitelists.end() || is_legacy_whitelisted(context.blenderid, context.scope, context.blender);
+        check(whitelisted, "You are not whitelisted for this blend.");
+    }
+
+    // check the merkle whitelist
+    if (blendconfig.whitelist_root != checksum256()) {
+        check(is_merkle_whitelisted(blendconfig.whitelist_root, context.blender, proof), "You are not whitelisted for this blend.");
     }
 
     // check the max uses
-    check(itrConfig->maxuse != 0, "The max use of the blend is currently zero.");
-    auto _blendstats = get_blendstats(scope);
-    auto itrBlendStats = _blendstats.find(blenderid);
-    if (itrBlendStats != _blendstats.end()) {
-        // check total uses
-        check(itrConfig->maxuse >= itrBlendStats->total_uses, "Maximum blend total use limit reached.");
+    check(blendconfig.maxuse != 0, "The max use of the blend is currently zero.");
+    if (blendconfig.maxuse != -1 && context.state != context.states.end()) {
+        check(blendconfig.maxuse >= int64_t(context.state->total_uses) + uses - 1, "Maximum blend total use limit reached.");
+    }
+
+    // a cooldown only allows one use per call
+    if (blendconfig.maxusercooldown != -1) {
+        check(uses == 1, "Blend has a user cooldown, batch blending is not allowed.");
     }
 
     // check the max user use
-    auto _blenduses = get_userblends(blender);
-    auto itrBlendUses = _blenduses.find(blenderid);
-    if (itrBlendUses != _blenduses.end()) {
-        if (itrConfig->maxuseruse != -1) {
+    if (context.useruse != context.userblends.end()) {
+        if (blendconfig.maxuseruse != -1) {
             // check maximum user use
-            check(itrBlendUses->uses <= itrConfig->maxuseruse, "Max user use has been reached!");
+            check(int64_t(context.useruse->uses) + uses - 1 <= blendconfig.maxuseruse, "Max user use has been reached!");
         }
 
-        if (itrConfig->maxusercooldown != -1) {
+        if (blendconfig.maxusercooldown != -1) {
             // check cooldown
-            check(now() - itrBlendUses->last_used > itrConfig->maxusercooldown, "Blend use is still in cooldown.");
+            check(now() - (BLEND_EPOCH + context.useruse->last_used) > blendconfig.maxusercooldown, "Blend use is still in cooldown.");
         }
     }
 }
@@ -51,80 +185,93 @@ void shomaiiblend::check_config(uint64_t blenderid, name blender, name scope) {
 /**
  * This is called when removing a blend.
  * An authorization check should be called before calling this one.
- * The difference with setconfig is that it checks if the config is set or not and raises an error.
+ * The config and the stats of the blend are removed to free up some ram, the ram is credited back to the collection.
+ * The whitelist is scoped by the blenderid only, so it should be emptied first or its rows can never be removed.
 */
-void shomaiiblend::remove_blend_config(uint64_t blenderid, name author, name scope) {
-    auto _blendconfig = get_blendconfigs(scope);
-    auto itrConfig = _blendconfig.find(blenderid);
+void shomaiiblend::remove_blend_state(uint64_t blenderid, name scope) {
+    // the names of the old config that are not moved yet are removed with it
+    auto oldconfigs = get_oldblendconfigs(scope);
+    auto itrConfig = oldconfigs.find(blenderid);
+    if (itrConfig != oldconfigs.end()) oldconfigs.erase(itrConfig);
+
+    auto oldstats = get_oldblendstats(scope);
+    auto itrStats = oldstats.find(blenderid);
+    if (itrStats != oldstats.end()) oldstats.erase(itrStats);
+
+    auto _whitelists = get_blendwhitelists(blenderid);
+    check(_whitelists.begin() == _whitelists.end(), "Blend still has whitelisted names, remove them first with remwhlist.");
+
+    auto _blendstates = get_blendstates(scope);
+    auto itrState = _blendstates.find(blenderid);
 
-    // do not remove if no config set
-    if (itrConfig == _blendconfig.end()) return;
+    // do not remove if no state found
+    if (itrState == _blendstates.end()) return;
 
-    // erase the config
-    _blendconfig.erase(itrConfig);
+    erase_charged(_blendstates, itrState, scope);
 }
 
 /**
- * This is called when removing the stats of a blend.
- * The main purpose is to free up some ram.
+ * This increments the blend total use and the blender's use by `uses`.
+ * Only the rows of the context are written back.
 */
-void shomaiiblend::remove_blend_stats(uint64_t blenderid, name author, name scope) {
-    auto _blendstats = get_blendstats(scope);
-    auto itrBlendstats = _blendstats.find(blenderid);
+void shomaiiblend::increment_blend_use(BlendContext &context, uint32_t uses) {
+    if (context.state == context.states.end()) {
+        // addd new stats info if it doesn't exist
+        context.state = emplace_charged(context.states, context.scope, [&](blendstate_s &row) {
+            row.blenderid = context.blenderid;
+            row.total_uses = uses;
+        });
+    } else {
+        // update stats
+        modify_charged(context.states, context.state, context.scope, [&](blendstate_s &row) {
+            row.total_uses = row.total_uses + uses;
+        });
+    }
+
+    // update or create the user's blend use on the blend if the cooldown is not infinite
+    if (context.config.maxusercooldown == -1) return;
 
-    // do not remove if no stats found
-    if (itrBlendstats == _blendstats.end()) return;
+    uint32_t last_used = uint32_t(now() - BLEND_EPOCH);
 
-    // erase the config
-    _blendstats.erase(itrBlendstats);
+    if (context.useruse == context.userblends.end()) {
+        context.useruse = emplace_charged(context.userblends, context.scope, [&](blenduse_s &row) {
+            row.blenderid = context.blenderid;
+            row.collection = context.scope;
+            row.last_used = last_used;
+            row.uses = uses;
+        });
+    } else {
+        modify_charged(context.userblends, context.useruse, context.scope, [&](blenduse_s &row) {
+            row.last_used = last_used;
+            row.uses = row.uses + uses;
+        });
+    }
 }
 
 /**
- * This increments the blend total use and the blender's use.
+ * Returns the decoded config of the blend, or the default config if the blend has none yet.
 */
-void shomaiiblend::increment_blend_use(uint64_t blenderid, name blender, name scope) {
-    auto _blendstats = get_blendstats(scope);
-    auto itrBlendstats = _blendstats.find(blenderid);
+BlendConfig shomaiiblend::load_blend_config(const blendstate_t &blendstates, blendstate_t::const_iterator itrState) {
+    if (itrState == blendstates.end() || itrState->config.empty()) return BlendConfig();
 
-    auto _blendconfig = get_blendconfigs(scope);
-    auto itrConfig = _blendconfig.find(blenderid);
+    return BlendConfig::decode(itrState->config);
+}
 
-    if (itrBlendstats == _blendstats.end()) {
-        // addd new stats info if it doesn't exist
-        _blendstats.emplace(blender, [&](blendstats_s &row) {
+/**
+ * Saves the encoded config of the blend, the row is created if the blend has no state yet.
+*/
+void shomaiiblend::save_blend_config(blendstate_t &blendstates, blendstate_t::const_iterator itrState, name scope, uint64_t blenderid, const BlendConfig &blendconfig) {
+    if (itrState == blendstates.end()) {
+        emplace_charged(blendstates, scope, [&](blendstate_s &row) {
             row.blenderid = blenderid;
-            row.total_uses = 1;
-        });
-    } else {
-        // update stats
-        _blendstats.modify(itrBlendstats, blender, [&](blendstats_s &row) {
-            row.total_uses = itrBlendstats->total_uses + 1;
+            row.config = blendconfig.encode();
         });
+        return;
     }
 
-    // update or create the user's blend use on the blend if the maxuserblend is not infinite
-    if (itrConfig != _blendconfig.end()) {
-        if (itrConfig->maxusercooldown != -1) {
-            // update only if cooldown is not infinite
-
-            auto _blenduses = get_userblends(blender);
-            auto itrBlendUses = _blenduses.find(blenderid);
-
-            if (itrBlendUses == _blenduses.end()) {
-                _blenduses.emplace(blender, [&](blendconfiguses_s &row) {
-                    row.blenderid = blenderid;
-                    row.blender = blender;
-                    row.last_used = now();
-                    row.uses = 1;
-                });
-            } else {
-                _blenduses.modify(itrBlendUses, blender, [&](blendconfiguses_s &row) {
-                    row.last_used = now();
-                    row.uses = itrBlendUses->uses + 1;
-                });
-            }
-        }
-    }
+    modify_charged(blendstates, itrState, scope, [&](blendstate_s &row) {
+        row.config = blendconfig.encode();
+    });
 }
 
 /**
@@ -135,38 +282,95 @@ ACTION shomaiiblend::removeconfig(name author, uint64_t blenderid, name scope) {
     require_auth(author);
     blockContract(author);
 
-    auto _blendconfig = get_blendconfigs(scope);
-    auto itrConfig = _blendconfig.require_find(blenderid, "Config of blend does not exist!");
-
     check(isAuthorized(scope, author), "User is not authorized in collection!");
 
-    // remove blend config
-    _blendconfig.erase(itrConfig);
+    migrateblendstate(blenderid, scope);
+
+    auto _blendstates = get_blendstates(scope);
+    auto itrState = _blendstates.find(blenderid);
+    check(itrState != _blendstates.end() && !itrState->config.empty(), "Config of blend does not exist!");
+
+    // remove blend config, the stats are kept
+    modify_charged(_blendstates, itrState, scope, [&](blendstate_s &row) {
+        row.config.clear();
+    });
+}
+
+/**
+ * Checks if the blend is owned by the scope.
+ * The blend whitelists are only scoped by the blenderid, so this is required before changing it.
+*/
+void shomaiiblend::check_blend_scope(uint64_t blenderid, name scope) {
+    check(blend_exists(blenderid, scope), "Blend does not exist in the scope!");
+}
+
+/**
+ * Checks if the blend is in any of the blend tables of the scope.
+*/
+bool shomaiiblend::blend_exists(uint64_t blenderid, name scope) {
+    auto _simpleblends = get_simpleblends(scope);
+    if (_simpleblends.find(blenderid) != _simpleblends.end()) return true;
+
+    auto _simpleswaps = get_simpleswaps(scope);
+    if (_simpleswaps.find(blenderid) != _simpleswaps.end()) return true;
+
+    auto _slotblends = get_slotblends(scope);
+    if (_slotblends.find(blenderid) != _slotblends.end()) return true;
+
+    auto oldslotblends = get_oldslotblends(scope);
+    if (oldslotblends.find(blenderid) != oldslotblends.end()) return true;
+
+    auto _hashblends = get_hashblends(scope);
+    return _hashblends.find(blenderid) != _hashblends.end();
 }
 
 /**
- * Set the whitelists. This will set the `names_list` to the `whitelists` and no other checking is done.
+ * Add the names to the blend's whitelist. Names that are already whitelisted are skipped.
 */
-ACTION shomaiiblend::setwhitelist(name author, uint64_t blenderid, name scope, vector<name> names_list) {
+ACTION shomaiiblend::addwhlist(name author, uint64_t blenderid, name scope, vector<name> names_list) {
     require_auth(author);
     blockContract(author);
 
-    auto _blendconfig = get_blendconfigs(scope);
-    auto itrConfig = _blendconfig.find(blenderid);
-
     check(isAuthorized(scope, author), "User is not authorized in collection!");
+    check_blend_scope(blenderid, scope);
 
-    if (itrConfig == _blendconfig.end()) {
-        _blendconfig.emplace(author, [&](blendconfig_s &row) {
-            row.blenderid = blenderid;
-            row.whitelists = names_list;
+    migrateblendstate(blenderid, scope);
+
+    auto _whitelists = get_blendwhitelists(blenderid);
+
+    for (auto i : names_list) {
+        if (_whitelists.find(i.value) != _whitelists.end()) continue;
+
+        emplace_charged(_whitelists, scope, [&](blendwhitelist_s &row) {
+            row.user = i;
         });
-        return;
     }
+}
 
-    _blendconfig.modify(itrConfig, author, [&](blendconfig_s &row) {
-        row.whitelists = names_list;
-    });
+/**
+ * Remove the names from the blend's whitelist. Names that are not whitelisted are skipped.
+*/
+ACTION shomaiiblend::remwhlist(name author, uint64_t blenderid, name scope, vector<name> names_list) {
+    require_auth(author);
+    blockContract(author);
+
+    check(isAuthorized(scope, author), "User is not authorized in collection!");
+    check_blend_scope(blenderid, scope);
+
+    migrateblendstate(blenderid, scope);
+
+    // the names of the old config would still be read by the blend
+    auto oldconfigs = get_oldblendconfigs(scope);
+    check(oldconfigs.find(blenderid) == oldconfigs.end(), "Blend whitelist is still being moved, sweep `blendconfig` first.");
+
+    auto _whitelists = get_blendwhitelists(blenderid);
+
+    for (auto i : names_list) {
+        auto itr = _whitelists.find(i.value);
+        if (itr == _whitelists.end()) continue;
+
+        erase_charged(_whitelists, itr, scope);
+    }
 }
 
 /**
@@ -176,22 +380,38 @@ ACTION shomaiiblend::setonwhlist(name author, uint64_t blenderid, name scope, bo
     require_auth(author);
     blockContract(author);
 
-    auto _blendconfig = get_blendconfigs(scope);
-    auto itrConfig = _blendconfig.find(blenderid);
+    check(isAuthorized(scope, author), "User is not authorized in collection!");
+
+    migrateblendstate(blenderid, scope);
+
+    auto _blendstates = get_blendstates(scope);
+    auto itrState = _blendstates.find(blenderid);
+
+    BlendConfig blendconfig = load_blend_config(_blendstates, itrState);
+    blendconfig.enable_whitelists = on_whitelist;
+
+    save_blend_config(_blendstates, itrState, scope, blenderid, blendconfig);
+}
+
+/**
+ * Set the merkle root of the blend whitelist. The root is the hash of the sorted pair of child hashes
+ * and each leaf is the sha256 of the account name's 8 byte value. Set an empty root to disable it.
+*/
+ACTION shomaiiblend::setwhroot(name author, uint64_t blenderid, name scope, checksum256 root) {
+    require_auth(author);
+    blockContract(author);
 
     check(isAuthorized(scope, author), "User is not authorized in collection!");
 
-    if (itrConfig == _blendconfig.end()) {
-        _blendconfig.emplace(author, [&](blendconfig_s &row) {
-            row.blenderid = blenderid;
-            row.enable_whitelists = on_whitelist;
-        });
-        return;
-    }
+    migrateblendstate(blenderid, scope);
 
-    _blendconfig.modify(itrConfig, author, [&](blendconfig_s &row) {
-        row.enable_whitelists = on_whitelist;
-    });
+    auto _blendstates = get_blendstates(scope);
+    auto itrState = _blendstates.find(blenderid);
+
+    BlendConfig blendconfig = load_blend_config(_blendstates, itrState);
+    blendconfig.whitelist_root = root;
+
+    save_blend_config(_blendstates, itrState, scope, blenderid, blendconfig);
 }
 
 /**
@@ -202,36 +422,31 @@ ACTION shomaiiblend::setdates(name author, uint64_t blenderid, name scope, int32
     require_auth(author);
     blockContract(author);
 
-    auto _blendconfig = get_blendconfigs(scope);
-    auto itrConfig = _blendconfig.find(blenderid);
-
     check(isAuthorized(scope, author), "User is not authorized in collection!");
 
+    migrateblendstate(blenderid, scope);
+
+    auto _blendstates = get_blendstates(scope);
+    auto itrState = _blendstates.find(blenderid);
+
+    BlendConfig blendconfig = load_blend_config(_blendstates, itrState);
+
     if (enddate != 0 && enddate != -1 && startdate != 0 && startdate != -1) {
-        if (itrConfig->startdate != startdate) {
+        if (blendconfig.startdate != startdate) {
             check(now() < startdate, "Start date should be greater than now.");
         }
 
-        if (itrConfig->enddate != enddate) {
+        if (blendconfig.enddate != enddate) {
             check(now() < enddate, "End date should be greater than now.");
         }
 
         check(enddate > startdate, "End date should be greater than the startdate.");
     }
 
-    if (itrConfig == _blendconfig.end()) {
-        _blendconfig.emplace(author, [&](blendconfig_s &row) {
-            row.blenderid = blenderid;
-            row.startdate = startdate;
-            row.enddate = enddate;
-        });
-        return;
-    }
+    blendconfig.startdate = startdate;
+    blendconfig.enddate = enddate;
 
-    _blendconfig.modify(itrConfig, author, [&](blendconfig_s &row) {
-        row.startdate = startdate;
-        row.enddate = enddate;
-    });
+    save_blend_config(_blendstates, itrState, scope, blenderid, blendconfig);
 }
 
 /**
@@ -242,24 +457,17 @@ ACTION shomaiiblend::setmax(name author, uint64_t blenderid, name scope, int32_t
     require_auth(author);
     blockContract(author);
 
-    auto _blendconfig = get_blendconfigs(scope);
-    auto itrConfig = _blendconfig.find(blenderid);
-
     check(isAuthorized(scope, author), "User is not authorized in collection!");
 
-    if (itrConfig == _blendconfig.end()) {
-        _blendconfig.emplace(author, [&](blendconfig_s &row) {
-            row.blenderid = blenderid;
-            row.maxuse = maxuse;
-            row.maxuseruse = maxuseruse;
-            row.maxusercooldown = maxusercooldown;
-        });
-        return;
-    }
+    migrateblendstate(blenderid, scope);
 
-    _blendconfig.modify(itrConfig, author, [&](blendconfig_s &row) {
-        row.maxuse = maxuse;
-        row.maxuseruse = maxuseruse;
-        row.maxusercooldown = maxusercooldown;
-    });
+    auto _blendstates = get_blendstates(scope);
+    auto itrState = _blendstates.find(blenderid);
+
+    BlendConfig blendconfig = load_blend_config(_blendstates, itrState);
+    blendconfig.maxuse = maxuse;
+    blendconfig.maxuseruse = maxuseruse;
+    blendconfig.maxusercooldown = maxusercooldown;
+
+    save_blend_config(_blendstates, itrState, scope, blenderid, blendconfig);
 };
\ No newline at end of file
@@ -18,7 +18,7 @@ void shomaiiblend::validate_multitarget(name collection, vector<MultiTarget> tar
     uint32_t total_counted_odds = 0;
     uint32_t lastodd = UINT32_MAX;
 
-    auto templates = atomicassets::get_templates(collection);
+    auto &templates = atomiccache.templates(collection);
 
     for (MultiTarget i : targets) {
         // check first if target template exists or not
@@ -56,51 +56,544 @@ void shomaiiblend::validate_caller(name user, name collection) {
  * Checks if the collection is whitelisted.
 */
 bool shomaiiblend::isWhitelisted(name collection) {
-    auto _sysconfig = sysconfig.get();
+    auto itr = services.find(collection.value);
 
-    return find(_sysconfig.whitelists.begin(), _sysconfig.whitelists.end(), collection) != _sysconfig.whitelists.end();
+    return itr != services.end() && itr->whitelisted;
 }
 
 /**
  * Checks if the collection is blacklisted.
 */
 bool shomaiiblend::isBlacklisted(name collection) {
-    auto _sysconfig = sysconfig.get();
+    auto itr = services.find(collection.value);
 
-    return find(_sysconfig.blacklists.begin(), _sysconfig.blacklists.end(), collection) != _sysconfig.blacklists.end();
+    return itr != services.end() && itr->blacklisted;
 }
 
 /**
- * Checks if the asset is transferred to the smart contract and if it exists in the refund table.
- * 
- * Returns the asset iterator.
+ * Checks if the collection only accepts its own assets when transferred for its blends.
 */
-atomicassets::assets_t::const_iterator shomaiiblend::validateasset(uint64_t asset, name owner) {
-    auto itrAssets = atomicassets::get_assets(get_self());
-    auto itr = itrAssets.require_find(asset, "The asset is not transferred to the smart contract for blending!");
+bool shomaiiblend::isStrictDeposits(name collection) {
+    auto itr = services.find(collection.value);
 
-    checkfromrefund(asset, owner);
+    return itr != services.end() && itr->strict_deposits;
+}
+
+/**
+ * Sets the service status of the collection, the entry is created if it does not exist.
+*/
+void shomaiiblend::set_service(name collection, bool whitelisted, bool blacklisted) {
+    auto itr = services.find(collection.value);
+
+    if (itr == services.end()) {
+        services.emplace(get_self(), [&](service_s &row) {
+            row.collection = collection;
+            row.whitelisted = whitelisted;
+            row.blacklisted = blacklisted;
+            row.strict_deposits = false;
+        });
+        return;
+    }
+
+    services.modify(itr, get_self(), [&](service_s &row) {
+        row.whitelisted = whitelisted;
+        row.blacklisted = blacklisted;
+    });
+}
+
+/**
+ * Checks the merkle proof of the user with the whitelist root.
+ * Each node is the sha256 of its two children, sorted, so the proof does not need the positions.
+*/
+bool shomaiiblend::is_merkle_whitelisted(const checksum256 &root, name user, const vector<checksum256> &proof) {
+    checksum256 node = sha256(reinterpret_cast<const char *>(&user.value), sizeof(user.value));
+
+    array<uint8_t, 64> pair;
+    for (const auto &i : proof) {
+        auto first = node < i ? node.extract_as_byte_array() : i.extract_as_byte_array();
+        auto second = node < i ? i.extract_as_byte_array() : node.extract_as_byte_array();
+
+        copy(first.begin(), first.end(), pair.begin());
+        copy(second.begin(), second.end(), pair.begin() + 32);
+
+        node = sha256(reinterpret_cast<const char *>(pair.data()), pair.size());
+    }
+
+    return node == root;
+}
+
+/**
+ * Checks if the assets exist in the owner's deposit ledger of the collection.
+ * The asset info is saved in the ledger when it is transferred, so the atomicassets tables are not read anymore.
+ *
+ * Returns the ledger iterator and the deposited assets.
+*/
+shomaiiblend::DepositedAssets shomaiiblend::validateassets(deposit_t &deposits, const vector<uint64_t> &assetids, name collection) {
+    check_duplicates(assetids);
+
+    DepositedAssets deposited;
+    deposited.ledger = deposits.require_find(collection.value, "The user has no transferred assets for the collection's blends!");
+    deposited.assets.reserve(assetids.size());
+
+    const auto &ledgerAssets = deposited.ledger->assets;
+    for (auto i : assetids) {
+        auto itr = findDeposit(ledgerAssets, i);
+        check(itr != ledgerAssets.end(), "The asset does not exist or is not transferred by the user to the smart contract!");
+
+        deposited.assets.push_back(*itr);
+    }
+
+    return deposited;
+}
+
+/**
+ * Checks if the assets are owned by the owner and returns their info, similar to the deposit ledger.
+ * This is used by the custody-free blends.
+*/
+vector<DepositAsset> shomaiiblend::validateownedassets(name owner, const vector<uint64_t> &assetids) {
+    check_duplicates(assetids);
+
+    auto assets = atomicassets::get_assets(owner);
+
+    vector<DepositAsset> owned = {};
+    owned.reserve(assetids.size());
+    for (auto i : assetids) {
+        auto itr = assets.require_find(i, "The asset is not owned by the blender!");
 
-    return itr;
+        owned.push_back(DepositAsset{i, itr->collection_name, itr->schema_name, itr->template_id});
+    }
+
+    return owned;
+}
+
+/**
+ * Checks if the assets are from the collection, used by the simple blends and swaps.
+ * Slot blends can have ingredients from other collections, these are checked by their slots.
+*/
+void shomaiiblend::check_assets_collection(const vector<DepositAsset> &assets, name collection) {
+    for (const auto &i : assets) {
+        check(i.collection == collection, "Collection of the asset is not the same with the blend!");
+    }
+}
+
+/**
+ * Checks for duplicate assets.
+*/
+void shomaiiblend::check_duplicates(vector<uint64_t> assetids) {
+    sort(assetids.begin(), assetids.end());
+    check(adjacent_find(assetids.begin(), assetids.end()) == assetids.end(), "Duplicate assets are not allowed!");
+}
+
+/**
+ * Checks if the templates of the assets are the ingredients of the simple blend.
+ * `ingredients` should already be sorted.
+*/
+void shomaiiblend::match_simple_ingredients(const vector<uint32_t> &ingredients, vector<DepositAsset>::const_iterator begin, vector<DepositAsset>::const_iterator end) {
+    vector<uint32_t> blendTemplates = {};
+    blendTemplates.reserve(ingredients.size());
+    for (auto i = begin; i != end; i++) {
+        blendTemplates.push_back(i->template_id);
+    }
+
+    sort(blendTemplates.begin(), blendTemplates.end());
+    check(blendTemplates == ingredients, "Invalid ingredients!");
+}
+
+/**
+ * Checks the assets with the slots of the slot blend.
+ * Each asset is classified once and is matched with the slots in any order.
+*/
+void shomaiiblend::match_slot_ingredients(const SlotProgram &program, const vector<DepositAsset> &assets) {
+    const vector<SlotPredicate> &slots = program.slots;
+
+    // check the total of assets to match with the slots
+    uint32_t totalAmount = 0;
+    for (const auto &j : slots) {
+        totalAmount += j.amount;
+    }
+    check(assets.size() == totalAmount, "The number of assets does not match the blend's ingredients!");
+
+    SlotMatcher matcher(slots, assets.size());
+    for (size_t i = 0; i < assets.size(); i++) {
+        for (size_t j = 0; j < slots.size(); j++) {
+            if (is_slot_ingredient(slots[j], assets[i])) {
+                matcher.add_candidate(i, j);
+            }
+        }
+    }
+
+    if (matcher.match()) return;
+
+    // the attribute slots only know the templates below the program's counter, the newer ones need a refresh first
+    for (const auto &j : slots) {
+        if (j.type != 2) continue;
+
+        for (const auto &i : assets) {
+            bool indexed = i.collection != j.collection || i.schema != j.schema || i.template_id < program.template_counter;
+            check(indexed, "The blend's recipe is still indexing templates, the author should refresh it with refreshslot or refreshhash!");
+        }
+    }
+
+    check(false, "The asset ingredients do not meet the required slots for blending!");
+}
+
+/**
+ * Validates the slot ingredient and compiles it into the blend's program.
+*/
+void shomaiiblend::compile_slot(const SlotBlendIngredient &ingredient, SlotProgram &program) {
+    check(ingredient.amount > 0, ("Ingredient amount should be atleast one or more. " + ingredient.collection.to_string()).c_str());
+
+    SlotPredicate slot;
+    slot.type = uint8_t(ingredient.props.index());
+    slot.collection = ingredient.collection;
+    slot.amount = ingredient.amount;
+    slot.require_all_attribs = false;
+
+    switch (ingredient.props.index()) {
+        case 0: {
+            // CHECK SCHEMA SLOT
+
+            const auto &_schema = get<SlotBlendSchemaIngredient>(ingredient.props);
+
+            auto &itrSchemas = atomiccache.schemas(ingredient.collection);
+            itrSchemas.require_find(_schema.schema.value, ("Schema does not exist in this collection! " + _schema.schema.to_string()).c_str());
+
+            slot.schema = _schema.schema;
+
+            break;
+        }
+        case 1: {
+            // CHECK TEMPLATE SLOT
+
+            const auto &_template = get<SlotBlendTemplateIngredient>(ingredient.props);
+
+            auto &itrTemplates = atomiccache.templates(ingredient.collection);
+            for (auto &j : _template.templates) {
+                itrTemplates.require_find(uint64_t(j), "Template does not exist in this collection!");
+            }
+
+            // sorted for binary search
+            slot.templates = _template.templates;
+            sort(slot.templates.begin(), slot.templates.end());
+            slot.templates.erase(unique(slot.templates.begin(), slot.templates.end()), slot.templates.end());
+
+            break;
+        }
+        case 2: {
+            // CHECK ATTRIBUTE SLOT
+
+            const auto &_attrib = get<SlotBlendAttribIngredient>(ingredient.props);
+
+            auto &itrSchemas = atomiccache.schemas(ingredient.collection);
+            auto itr = itrSchemas.require_find(_attrib.schema.value, "Schema does not exist in this collection!");
+
+            slot.schema = _attrib.schema;
+            slot.require_all_attribs = _attrib.require_all_attribs;
+
+            for (const auto &j : _attrib.attributes) {
+                // the key is stored as its index in the schema format, same with the serialized data
+                auto itrKey = find_if(itr->format.begin(), itr->format.end(), [&](const FORMAT &f) { return f.name == j.key; });
+                check(itrKey != itr->format.end(), "Attribute key does not exist in schema!");
+
+                check(j.match <= ATTRIB_MATCH_PREFIX, "Invalid attribute match mode!");
+
+                SlotPredicateAttrib attrib;
+                attrib.key = uint16_t(itrKey - itr->format.begin());
+                attrib.match = j.match;
+
+                // intern the allowed values
+                for (const auto &v : j.allowed_values) {
+                    auto itrValue = find(program.values.begin(), program.values.end(), v);
+
+                    if (itrValue == program.values.end()) {
+                        check(program.values.size() < UINT16_MAX, "Too many allowed values in the blend!");
+                        attrib.values.push_back(uint16_t(program.values.size()));
+                        program.values.push_back(v);
+                    } else {
+                        attrib.values.push_back(uint16_t(itrValue - program.values.begin()));
+                    }
+                }
+
+                // sorted by the value for binary search, similar values have similar ids
+                sort(attrib.values.begin(), attrib.values.end(), [&](uint16_t a, uint16_t b) { return program.values[a] < program.values[b]; });
+                attrib.values.erase(unique(attrib.values.begin(), attrib.values.end()), attrib.values.end());
+
+                slot.attributes.push_back(attrib);
+            }
+
+            for (const auto &j : _attrib.numeric_attributes) {
+                auto itrKey = find_if(itr->format.begin(), itr->format.end(), [&](const FORMAT &f) { return f.name == j.key; });
+                check(itrKey != itr->format.end(), "Attribute key does not exist in schema!");
+
+                bool isInteger = atomicdata::is_integer_type(itrKey->type);
+                check(isInteger || itrKey->type == "float" || itrKey->type == "double", "Numeric attribute should be an integer, float or double!");
+
+                SlotPredicateNumeric numeric;
+                numeric.key = uint16_t(itrKey - itr->format.begin());
+                numeric.op = j.op;
+                numeric.values = {};
+                numeric.min = 0;
+                numeric.max = 0;
+                numeric.bitmask = 0;
+
+                switch (j.op) {
+                    case NUMERIC_IN_SET: {
+                        check(j.values.size() != 0, "Numeric attribute requires one or more values.");
+
+                        // sorted for binary search
+                        numeric.values = j.values;
+                        sort(numeric.values.begin(), numeric.values.end());
+                        numeric.values.erase(unique(numeric.values.begin(), numeric.values.end()), numeric.values.end());
+                        break;
+                    }
+                    case NUMERIC_RANGE: {
+                        check(j.min <= j.max, "Numeric attribute min should not be greater than max.");
+
+                        numeric.min = j.min;
+                        numeric.max = j.max;
+                        break;
+                    }
+                    case NUMERIC_BITMASK: {
+                        check(isInteger, "Bitmask can only be used with integer attributes!");
+
+                        numeric.bitmask = j.bitmask;
+                        break;
+                    }
+                    default: {
+                        check(false, "Invalid numeric attribute operation!");
+                    }
+                }
+
+                slot.numeric_attributes.push_back(numeric);
+            }
+
+            // the qualifying templates are checked by `refresh_program`, the call will only need to look up the template id
+
+            break;
+        }
+        default: {
+            check(false, "Invalid ignredient type!");
+        }
+    }
+
+    program.slots.push_back(slot);
+}
+
+/**
+ * Checks at most `limit` templates of the slot's collection with ids from `from` to below `to`,
+ * the templates of the slot's schema that meet the attributes are added to the slot's templates.
+ * Returns the template id where the scan stopped, this is `to` if all of the templates were checked.
+*/
+int32_t shomaiiblend::scan_attrib_templates(SlotPredicate &slot, const vector<string> &values, const vector<FORMAT> &format, int32_t from, int32_t to, uint32_t limit) {
+    auto &itrTemplates = atomiccache.templates(slot.collection);
+
+    // template ids are increasing, so the slot's templates stays sorted
+    for (auto itr = itrTemplates.lower_bound(uint64_t(from)); itr != itrTemplates.end() && itr->template_id < to; itr++) {
+        if (limit == 0) return itr->template_id;
+        limit--;
+
+        if (itr->schema_name == slot.schema && is_attrib_template(slot, values, itr->immutable_serialized_data, format)) {
+            slot.templates.push_back(uint32_t(itr->template_id));
+        }
+    }
+
+    return to;
+}
+
+/**
+ * Checks the templates that were created after the program was compiled or last refreshed for its attribute slots.
+ * At most `limit` templates are checked per slot, `template_counter` is where the next refresh continues.
+*/
+void shomaiiblend::refresh_program(SlotProgram &program, uint32_t limit) {
+    int32_t from = program.template_counter;
+    int32_t to = atomicassets::config.get().template_counter;
+
+    for (auto &slot : program.slots) {
+        if (slot.type != 2) continue;
+
+        auto &itrSchemas = atomiccache.schemas(slot.collection);
+        auto itrSchema = itrSchemas.require_find(slot.schema.value, "Schema does not exist in the ingredient's collection!");
+
+        to = scan_attrib_templates(slot, program.values, itrSchema->format, from, to, limit);
+    }
+
+    // the slots checked before the scan stopped may have gone further, those templates are checked again by the next refresh
+    for (auto &slot : program.slots) {
+        if (slot.type != 2) continue;
+
+        slot.templates.erase(lower_bound(slot.templates.begin(), slot.templates.end(), uint32_t(to)), slot.templates.end());
+    }
+
+    program.template_counter = to;
+}
+
+/**
+ * Hash of the compiled recipe of the hash slot blends.
+*/
+checksum256 shomaiiblend::recipe_hash(const SlotProgram &program) {
+    auto packed = pack(program);
+    return sha256(packed.data(), packed.size());
+}
+
+/**
+ * Checks if the asset can be used as an ingredient for the compiled slot.
+*/
+bool shomaiiblend::is_slot_ingredient(const SlotPredicate &slot, const DepositAsset &asset) {
+    if (asset.collection != slot.collection) return false;
+
+    switch (slot.type) {
+        case 0: {
+            // check if they have the required schemas
+            return asset.schema == slot.schema;
+        }
+        case 1: {
+            return binary_search(slot.templates.begin(), slot.templates.end(), uint32_t(asset.template_id));
+        }
+        case 2: {
+            // qualifying templates are already checked when the blend was made or refreshed
+            if (asset.schema != slot.schema || asset.template_id < 0) return false;
+
+            return binary_search(slot.templates.begin(), slot.templates.end(), uint32_t(asset.template_id));
+        }
+        default: {
+            check(false, "Invalid ingredient type!");
+            return false;
+        }
+    }
+}
+
+/**
+ * Checks if the template's immutable data meets the attributes of the compiled slot.
+ * Only the attributes of the slot are read from the serialized data, the others are skipped.
+*/
+bool shomaiiblend::is_attrib_template(const SlotPredicate &slot, const vector<string> &values, const vector<uint8_t> &data, const vector<FORMAT> &format) {
+    // string attributes first, then the numeric attributes
+    vector<uint64_t> keys = {};
+    keys.reserve(slot.attributes.size() + slot.numeric_attributes.size());
+    for (const auto &x : slot.attributes) {
+        keys.push_back(x.key);
+    }
+    for (const auto &x : slot.numeric_attributes) {
+        keys.push_back(x.key);
+    }
+
+    auto positions = atomicdata::locate(data, format, keys);
+
+    for (size_t x = 0; x < keys.size(); x++) {
+        bool ok = false;
+
+        const string &type = format[keys[x]].type;
+        auto itr = positions[x];
+
+        if (itr == data.end()) {
+            ok = false;
+        } else if (x < slot.attributes.size()) {
+            if (type == "string" || type == "image") {
+                std::string_view value = atomicdata::deserialize_string_view(itr);
+                ok = is_allowed_value(slot.attributes[x], values, value);
+            } else if (type == "ipfs") {
+                // ipfs hashes are saved as raw bytes, they are matched with their base58 text
+                string value = get<string>(atomicdata::deserialize_attribute(type, itr));
+                ok = is_allowed_value(slot.attributes[x], values, value);
+            }
+        } else {
+            ok = is_allowed_number(slot.numeric_attributes[x - slot.attributes.size()], type, itr);
+        }
+
+        if (ok && !slot.require_all_attribs) return true;
+        if (!ok && slot.require_all_attribs) return false;
+    }
+
+    return slot.require_all_attribs;
+}
+
+/**
+ * Checks the numeric attribute value, it is read directly from the serialized data.
+*/
+bool shomaiiblend::is_allowed_number(const SlotPredicateNumeric &numeric, const string &type, vector<const uint8_t>::iterator itr) {
+    if (!atomicdata::is_integer_type(type)) {
+        double value = atomicdata::deserialize_floating(type, itr);
+
+        switch (numeric.op) {
+            case NUMERIC_IN_SET: {
+                for (auto v : numeric.values) {
+                    if (value == double(v)) return true;
+                }
+                return false;
+            }
+            case NUMERIC_RANGE: {
+                return value >= double(numeric.min) && value <= double(numeric.max);
+            }
+            default: {
+                return false;
+            }
+        }
+    }
+
+    int64_t value = atomicdata::deserialize_integer(type, itr);
+
+    switch (numeric.op) {
+        case NUMERIC_IN_SET: {
+            return binary_search(numeric.values.begin(), numeric.values.end(), value);
+        }
+        case NUMERIC_RANGE: {
+            return value >= numeric.min && value <= numeric.max;
+        }
+        case NUMERIC_BITMASK: {
+            return (uint64_t(value) & numeric.bitmask) == numeric.bitmask;
+        }
+        default: {
+            return false;
+        }
+    }
+}
+
+/**
+ * Checks the attribute value with the allowed values of the compiled attribute.
+*/
+bool shomaiiblend::is_allowed_value(const SlotPredicateAttrib &attrib, const vector<string> &values, std::string_view value) {
+    switch (attrib.match) {
+        case ATTRIB_MATCH_EXACT: {
+            // allowed values are sorted, so only one lookup is needed
+            auto itr = lower_bound(attrib.values.begin(), attrib.values.end(), value, [&](uint16_t a, std::string_view b) { return std::string_view(values[a]) < b; });
+
+            return itr != attrib.values.end() && values[*itr] == value;
+        }
+        case ATTRIB_MATCH_PREFIX: {
+            for (auto y : attrib.values) {
+                if (value.substr(0, values[y].size()) == values[y]) return true;
+            }
+
+            return false;
+        }
+        default: {
+            for (auto y : attrib.values) {
+                // check if attribute value includes the allowed_value
+                if (value.find(values[y]) != std::string_view::npos) return true;
+            }
+
+            return false;
+        }
+    }
 }
 
 // get the collection from the atomicassets contract
 atomicassets::collections_t::const_iterator shomaiiblend::get_collection(name author, name collection) {
     // validate target collection
-    auto itrCol = atomicassets::collections.require_find(collection.value, "This collection does not exist!");
+    auto itrCol = atomiccache.collection(collection);
 
     // validate author
     check(isAuthorized(collection, author), "You are not authorized in this collection!");
 
     // validate contract is authorized by collection
-    check(isAuthorized(collection, author), "Contract is not authorized in the collection!");
+    check(isAuthorized(collection, get_self()), "Contract is not authorized in the collection!");
 
     return itrCol;
 }
 
 // get the target template iterator
 atomicassets::templates_t::const_iterator shomaiiblend::get_target_template(name scope, uint64_t target_template) {
-    auto templates = atomicassets::get_templates(scope);
+    auto &templates = atomiccache.templates(scope);
     auto itrTemplate = templates.require_find(target_template, "Target template not found from collection!");
 
     // check collection mint limit and supply
@@ -112,7 +605,7 @@ atomicassets::templates_t::const_iterator shomaiiblend::get_target_template(name
 /*
       Call AtomicAssets contract to mint a new NFT
    */
-void shomaiiblend::mintasset(name collection, name schema, uint64_t templateid, name to) {
+void shomaiiblend::mintasset(name collection, name schema, uint64_t templateid, name to, int64_t table_bytes) {
     vector<asset> back_tokens;
     atomicassets::ATTRIBUTE_MAP nodata = {};
 
@@ -126,8 +619,25 @@ void shomaiiblend::mintasset(name collection, name schema, uint64_t templateid,
         make_tuple(get_self(), collection, schema, _template, to, nodata, nodata, back_tokens))
         .send();
 
-    // decrease the ram
-    decrease_ram_balance(collection, 151);
+    // the asset row is paid by the smart contract, the recipient's table is charged once by the caller with `table_bytes`
+    atomicassets::assets_s minted = {0, collection, schema, _template, get_self(), back_tokens, {}, {}};
+
+    decrease_ram_balance(collection, row_bytes(minted) + table_bytes);
+}
+
+/**
+ * Returns the bytes of the recipient's asset table that the first mint of the call creates.
+ * The `taken` assets are transferred before the mint, so the table is created again if they are all of the recipient's assets.
+*/
+int64_t shomaiiblend::mint_table_bytes(name to, const vector<uint64_t> &taken) {
+    auto recipientassets = atomicassets::get_assets(to);
+
+    // stops at the first asset that is kept, so at most `taken` + 1 rows are read
+    for (auto itr = recipientassets.begin(); itr != recipientassets.end(); itr++) {
+        if (find(taken.begin(), taken.end(), itr->asset_id) == taken.end()) return 0;
+    }
+
+    return TABLE_OVERHEAD_BYTES;
 }
 
 /*
@@ -155,43 +665,116 @@ void shomaiiblend::transferassets(vector<uint64_t> assets, name to) {
         .send();
 }
 
+/*
+    Call AtomicAssets contract to transfer the owner's assets to the smart contract, used by the custody-free blends.
+    The owner's `blend` permission should have the `eosio.code` of the smart contract.
+    The transfer is saved as pending, so `savetransfer` only accepts the custody-free memo for it.
+*/
+void shomaiiblend::takeassets(name owner, vector<uint64_t> assets) {
+    check(pendingtakes.find(owner.value) == pendingtakes.end(), "The blender already has a pending custody-free blend.");
+
+    pendingtakes.emplace(get_self(), [&](pendingtake_s &row) {
+        row.owner = owner;
+        row.assets = assets;
+    });
+
+    action(
+        permission_level{owner, BLEND_PERMISSION},
+        ATOMICASSETS,
+        name("transfer"),
+        make_tuple(owner, get_self(), assets, CUSTODYFREE_MEMO))
+        .send();
+}
+
+/*
+    Consumes the pending custody-free transfer of the owner, the assets should be the ones taken by `takeassets`.
+*/
+void shomaiiblend::receivetake(name owner, vector<uint64_t> assets) {
+    auto itr = pendingtakes.find(owner.value);
+    check(itr != pendingtakes.end() && itr->assets == assets, "Custody-free memo is only used by the smart contract's blends!");
+
+    pendingtakes.erase(itr);
+}
+
 /*
       Check if user is authorized to mint NFTs
    */
 bool shomaiiblend::isAuthorized(name collection, name user) {
-    auto itr = atomicassets::collections.require_find(collection.value, "No collection with this name exists!");
-    bool authorized = false;
-    vector<name> accs = itr->authorized_accounts;
-    for (auto it = accs.begin(); it != accs.end() && !authorized; it++) {
-        if (user == name(*it)) {
-            authorized = true;
-        }
-    }
-    return authorized;
+    return atomiccache.is_authorized(collection, user);
 }
 
 /**
-	 * Checks and confirms if the asset is in the nftrefunds table within the scope of the owner.
-	*/
-void shomaiiblend::checkfromrefund(uint64_t assetid, name owner) {
-    auto refunds = get_nftrefunds(owner);
-    refunds.require_find(assetid, "The asset does not exist or is not transferred by the user to the smart contract!");
+ * Find the asset in the sorted deposited assets.
+*/
+vector<DepositAsset>::const_iterator shomaiiblend::findDeposit(const vector<DepositAsset> &assets, uint64_t assetid) {
+    auto itr = lower_bound(assets.begin(), assets.end(), assetid, [](const DepositAsset &a, uint64_t b) { return a.asset_id < b; });
+
+    if (itr != assets.end() && itr->asset_id == assetid) return itr;
+    return assets.end();
+}
+
+/**
+ * Add the transferred assets to the user's deposit ledger of the collection.
+*/
+void shomaiiblend::addDeposits(deposit_t &deposits, name collection, vector<DepositAsset> assets) {
+    auto byId = [](const DepositAsset &a, const DepositAsset &b) { return a.asset_id < b.asset_id; };
+    sort(assets.begin(), assets.end(), byId);
+
+    auto itr = deposits.find(collection.value);
+    uint32_t last_deposit = uint32_t(now() - BLEND_EPOCH);
+
+    if (itr == deposits.end()) {
+        deposits.emplace(get_self(), [&](deposit_s &row) {
+            row.collection = collection;
+            row.assets = assets;
+            row.last_deposit = last_deposit;
+        });
+        return;
+    }
+
+    vector<DepositAsset> merged = {};
+    merged.reserve(itr->assets.size() + assets.size());
+    set_union(itr->assets.begin(), itr->assets.end(), assets.begin(), assets.end(), back_inserter(merged), byId);
+
+    deposits.modify(itr, get_self(), [&](deposit_s &row) {
+        row.assets = merged;
+        row.last_deposit = last_deposit;
+    });
 }
 
 /*
-    Remove NFTs from refund after a successfull action.
+    Remove NFTs from the deposit ledger after a successfull action, the ledger is erased if it is empty.
   */
-void shomaiiblend::removeRefundNFTs(name from, name collection, vector<uint64_t> assetids) {
-    auto refundtable = get_nftrefunds(from);
+void shomaiiblend::removeRefundNFTs(deposit_t &deposits, deposit_t::const_iterator ledger, vector<uint64_t> assetids) {
+    sort(assetids.begin(), assetids.end());
+
+    vector<DepositAsset> remaining = {};
+    remaining.reserve(ledger->assets.size());
+    for (const auto &i : ledger->assets) {
+        if (!binary_search(assetids.begin(), assetids.end(), i.asset_id)) {
+            remaining.push_back(i);
+        }
+    }
 
-    for (auto i : assetids) {
-        auto itr = refundtable.find(i);
+    if (remaining.size() == 0) {
+        deposits.erase(ledger);
+        return;
+    }
 
-        // some checking in here for sure
-        check(itr->from == from, "The asset does not come from you!");
-        check(itr->collection == collection, "The asset was not sent to the collection's blend.");  // kind of useless check in here
+    deposits.modify(ledger, get_self(), [&](deposit_s &row) {
+        row.assets = remaining;
+    });
+}
 
-        // remove it
-        refundtable.erase(itr);
+/*
+    Remove the validated NFTs from the deposit ledger after a successfull action.
+  */
+void shomaiiblend::removeRefundNFTs(deposit_t &deposits, const DepositedAssets &deposited) {
+    vector<uint64_t> assetids = {};
+    assetids.reserve(deposited.assets.size());
+    for (const auto &i : deposited.assets) {
+        assetids.push_back(i.asset_id);
     }
-}
+
+    removeRefundNFTs(deposits, deposited.ledger, assetids);
+}
\ No newline at end of file
@@ -38,7 +38,7 @@ ACTION shomaiiblend::makeswsimple(name author, name collection, uint32_t target,
     auto itrCol = get_collection(author, collection);
 
     // get target collection
-    auto templates = atomicassets::get_templates(collection);
+    auto &templates = atomiccache.templates(collection);
 
     // validate template if exists in collection
     check(templates.find(target) != templates.end(), "Template does not exist in collection!");
@@ -82,87 +82,224 @@ ACTION shomaiiblend::makeblslot(name author, name collection, vector<MultiTarget
         validate_multitarget(collection, targets);
     }
 
-    // validate ingredients
-    for (auto i : ingredients) {
-        check(i.amount > 0, ("Ingredient amount should be atleast one or more. " + i.collection.to_string()).c_str());
+    // get burner counter
+    config_s current_config = config.get();
+    uint64_t blenderid = current_config.blendercounter++;
+    config.set(current_config, get_self());
 
-        auto props = i.props;
+    // the ingredients and targets are shared with the blends that have the same content
+    uint64_t specid = acquire_slotspec(collection, author, ingredients);
+    uint64_t poolid = acquire_targetspec(collection, author, targets);
 
-        switch (props.index()) {
-            case 0: {
-                // CHECK SCHEMA SLOT
+    auto slotblends = get_slotblends(collection);
 
-                auto _schema = get<SlotBlendSchemaIngredient>(props);
+    // store slotblend
+    slotblends.emplace(author, [&](slotblend_s &row) {
+        row.blenderid = blenderid;
+        row.author = author;
 
-                auto itrSchemas = atomicassets::get_schemas(i.collection);
-                itrSchemas.require_find(_schema.schema.value, ("Schema does not exist in this collection! " + _schema.schema.to_string()).c_str());
+        row.collection = collection;
+        row.specid = specid;
+        row.poolid = poolid;
 
-                break;
-            }
-            case 1: {
-                // CHECK TEMPLATE SLOT
+        row.title = title;
+    });
+}
 
-                auto _template = get<SlotBlendTemplateIngredient>(props);
+/**
+ * Refresh the qualifying templates of the attribute slots of a Slot Blend.
+ * Only the templates after the last checked one are checked, at most `limit` per slot. Call again until the
+ * program's `template_counter` reaches the atomicassets template counter.
+*/
+ACTION shomaiiblend::refreshslot(name author, name scope, uint64_t blenderid, uint32_t limit) {
+    require_auth(author);
+    blockContract(author);
 
-                auto itrTemplates = atomicassets::get_templates(i.collection);
-                for (auto &j : _template.templates) {
-                    itrTemplates.require_find(uint64_t(j), "Template does not exist in this collection!");
-                }
+    check(limit > 0, "Limit should be greater than zero.");
 
-                break;
-            }
-            case 2: {
-                // CHECK ATTRIBUTE SLOT
+    auto _slotblends = get_slotblends(scope);
+    auto itr = _slotblends.require_find(blenderid, "Slot Blender does not exist!");
 
-                auto _attrib = get<SlotBlendAttribIngredient>(props);
+    check(isAuthorized(itr->collection, author), "User is not authorized in this collection!");
 
-                auto itrSchemas = atomicassets::get_schemas(i.collection);
-                auto itr = itrSchemas.require_find(_attrib.schema.value, "Schema does not exist in this collection!");
+    // the spec is shared, so this also refreshes the blends with the same ingredients
+    auto slotspecs = get_slotspecs(scope);
+    auto itrSpec = slotspecs.require_find(itr->specid, "Slot spec does not exist!");
 
-                for (auto j : _attrib.attributes) {
-                    bool keyExists;
+    slotspecs.modify(itrSpec, author, [&](slotspec_s &row) {
+        refresh_program(row.program, limit);
+    });
+}
 
-                    for (auto s : itr->format) {
-                        if (s.name == j.key) {
-                            keyExists = true;
-                        }
-                    }
+/**
+ * Move a Slot Blend saved before the shared specs to the `slotblends` table.
+ * The ingredients are compiled into a shared spec and the targets are moved to a shared pool, both paid by the author.
+ * The old target pool is kept while the old claim jobs may still need it, `sweep` removes it later.
+*/
+ACTION shomaiiblend::migslotblend(name author, name scope, uint64_t blenderid) {
+    require_auth(author);
+    blockContract(author);
 
-                    check(keyExists, "Attribute key does not exist in schema!");
-                }
+    auto oldslotblends = get_oldslotblends(scope);
+    auto itrOld = oldslotblends.require_find(blenderid, "Slot Blender does not exist or was already migrated!");
 
-                break;
-            }
-            default: {
-                check(false, "Invalid ignredient type!");
+    check(isAuthorized(itrOld->collection, author), "User is not authorized in this collection!");
+
+    vector<SlotBlendIngredient> ingredients = {};
+    ingredients.reserve(itrOld->ingredients.size());
+    for (const auto &i : itrOld->ingredients) {
+        ingredients.push_back(upgrade_ingredient(i));
+    }
+
+    auto oldtargets = get_blendertargets(scope);
+    auto itrTargets = oldtargets.require_find(blenderid, "Blender's target pool does not exist.");
+
+    uint64_t specid = acquire_slotspec(scope, author, ingredients);
+    uint64_t poolid = acquire_targetspec(scope, author, itrTargets->targets);
+
+    auto slotblends = get_slotblends(scope);
+    slotblends.emplace(author, [&](slotblend_s &row) {
+        row.blenderid = blenderid;
+        row.author = itrOld->author;
+
+        row.collection = itrOld->collection;
+        row.specid = specid;
+        row.poolid = poolid;
+
+        row.title = itrOld->title;
+    });
+
+    oldslotblends.erase(itrOld);
+
+    if (oldclaimjobs.begin() == oldclaimjobs.end()) {
+        oldtargets.erase(itrTargets);
+    }
+}
+
+/**
+ * Converts the slot ingredient saved before the match modes, the allowed values were matched as substrings.
+*/
+SlotBlendIngredient shomaiiblend::upgrade_ingredient(const OldSlotBlendIngredient &ingredient) {
+    SlotBlendIngredient upgraded;
+    upgraded.type = ingredient.type;
+    upgraded.collection = ingredient.collection;
+    upgraded.amount = ingredient.amount;
+
+    switch (ingredient.props.index()) {
+        case 0: {
+            upgraded.props = get<SlotBlendSchemaIngredient>(ingredient.props);
+            break;
+        }
+        case 1: {
+            upgraded.props = get<SlotBlendTemplateIngredient>(ingredient.props);
+            break;
+        }
+        default: {
+            const auto &_attrib = get<OldSlotBlendAttribIngredient>(ingredient.props);
+
+            SlotBlendAttribIngredient attrib;
+            attrib.schema = _attrib.schema;
+            attrib.require_all_attribs = _attrib.require_all_attribs;
+            attrib.numeric_attributes = {};
+
+            for (const auto &j : _attrib.attributes) {
+                attrib.attributes.push_back(SlotBlendAttribValuesIngredient{j.key, ATTRIB_MATCH_SUBSTRING, j.allowed_values});
             }
+
+            upgraded.props = attrib;
         }
     }
 
+    return upgraded;
+}
+
+/**
+ * Make a Slot Blend that only keeps the hash of its compiled recipe.
+ * The ingredients are validated and compiled like `makeblslot`, then the program is logged with `logrecipe`.
+*/
+ACTION shomaiiblend::makeblhash(name author, name collection, vector<MultiTarget> targets, vector<SlotBlendIngredient> ingredients) {
+    validate_caller(author, collection);
+
+    // validate target collection
+    get_collection(author, collection);
+
+    // check size and lengths
+    check(targets.size() != 0, "Required one or more targets.");
+    check(ingredients.size() != 0, "Required one or more ingredients.");
+
+    // check multitarget only if more than one target
+    if (targets.size() > 1) {
+        validate_multitarget(collection, targets);
+    }
+
+    // validate and compile the ingredients, the first templates of the attribute slots are checked now
+    SlotProgram program;
+    program.template_counter = 0;
+    for (const auto &i : ingredients) {
+        compile_slot(i, program);
+    }
+    refresh_program(program, MAX_TEMPLATE_SCAN);
+
     // get burner counter
     config_s current_config = config.get();
     uint64_t blenderid = current_config.blendercounter++;
     config.set(current_config, get_self());
 
-    auto slotblends = get_slotblends(collection);
-    auto mtargets = get_blendertargets(collection);
+    uint64_t poolid = acquire_targetspec(collection, author, targets);
 
-    // store slotblend
-    slotblends.emplace(author, [&](slotblend_s &row) {
+    auto hashblends = get_hashblends(collection);
+
+    // store only the hash of the recipe
+    hashblends.emplace(author, [&](hashblend_s &row) {
         row.blenderid = blenderid;
         row.author = author;
 
         row.collection = collection;
-        row.ingredients = ingredients;
-
-        row.title = title;
+        row.recipe = recipe_hash(program);
+        row.poolid = poolid;
     });
 
-    // store multi targets
-    mtargets.emplace(author, [&](multitarget_s &row) {
-        row.blenderid = blenderid;
-        row.collection = collection;
+    action(
+        permission_level{get_self(), name("active")},
+        get_self(),
+        name("logrecipe"),
+        make_tuple(blenderid, collection, program))
+        .send();
+}
+
+/**
+ * Refresh the qualifying templates of the attribute slots of a hash Slot Blend, at most `limit` templates per slot.
+ * The current recipe is passed by the author, the refreshed recipe is logged with `logrecipe`.
+*/
+ACTION shomaiiblend::refreshhash(name author, name scope, uint64_t blenderid, SlotProgram program, uint32_t limit) {
+    require_auth(author);
+    blockContract(author);
 
-        row.targets = targets;
+    check(limit > 0, "Limit should be greater than zero.");
+
+    auto _hashblends = get_hashblends(scope);
+    auto itr = _hashblends.require_find(blenderid, "Slot Blender does not exist!");
+
+    check(isAuthorized(itr->collection, author), "User is not authorized in this collection!");
+    check(recipe_hash(program) == itr->recipe, "The recipe does not match the blend!");
+
+    refresh_program(program, limit);
+
+    _hashblends.modify(itr, author, [&](hashblend_s &row) {
+        row.recipe = recipe_hash(program);
     });
-}
\ No newline at end of file
+
+    action(
+        permission_level{get_self(), name("active")},
+        get_self(),
+        name("logrecipe"),
+        make_tuple(blenderid, scope, program))
+        .send();
+}
+
+/**
+ * Logs the compiled recipe of a hash Slot Blend, so the callers can read it from the action history.
+*/
+ACTION shomaiiblend::logrecipe(uint64_t, name, SlotProgram) {
+    require_auth(get_self());
+}
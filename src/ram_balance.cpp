@@ -107,6 +107,17 @@ void shomaiiblend::decrease_ram_balance(name collection, int64_t bytes) {
     });
 }
 
+/**
+ * Internal function to charge the ram used by the smart contract for the collection, a negative value credits the freed ram back.
+*/
+void shomaiiblend::charge_ram_balance(name collection, int64_t bytes) {
+    if (bytes > 0) {
+        decrease_ram_balance(collection, bytes);
+    } else if (bytes < 0) {
+        increase_ram_balance(collection, -bytes);
+    }
+}
+
 /**
  * Internal function to increase the ram balance.
 */
@@ -116,10 +127,13 @@ void shomaiiblend::increase_ram_balance(name collection, int64_t bytes) {
     auto itr = rambalances.find(collection.value);
 
     if (itr == rambalances.end()) {
-        check(bytes >= 144, "Ram balance should be greater than 144 for the table entry.");  // this is for the claimjob entry (TODO: find a good alt)
+        // the balance row itself is paid from the first deposit
+        int64_t entry = row_bytes(rambalance_s{collection, 0});
+        check(bytes >= entry, "Ram balance should be greater than " + to_string(entry) + " for the table entry.");
+
         rambalances.emplace(_self, [&](rambalance_s &row) {
             row.collection = collection;
-            row.bytes = bytes - 144;
+            row.bytes = bytes - entry;
         });
         return;
     }
@@ -17,11 +17,8 @@ ACTION shomaiiblend::remblsimple(name user, name scope, uint64_t blenderid) {
     // remove item
     _simpleblends.erase(itr);
 
-    // remove blend config if it exists
-    remove_blend_config(blenderid, user, scope);
-
-    // remove blend stats if it exists
-    remove_blend_stats(blenderid, user, scope);
+    // remove blend config and stats if it exists
+    remove_blend_state(blenderid, scope);
 }
 
 /**
@@ -41,11 +38,8 @@ ACTION shomaiiblend::remswsimple(name user, name scope, uint64_t blenderid) {
     // remove item
     _simpleswaps.erase(itr);
 
-    // remove blend config if it exists
-    remove_blend_config(blenderid, user, scope);
-
-    // remove blend stats if it exists
-    remove_blend_stats(blenderid, user, scope);
+    // remove blend config and stats if it exists
+    remove_blend_state(blenderid, scope);
 }
 
 /**
@@ -57,17 +51,54 @@ ACTION shomaiiblend::remblslot(name user, name scope, uint64_t blenderid) {
     blockContract(user);
 
     auto _slotblends = get_slotblends(scope);
-    auto itr = _slotblends.require_find(blenderid, "Burner ID does not exist!");
+    auto itr = _slotblends.find(blenderid);
+
+    // slot blends saved before the shared specs have no spec, their old target pool is removed by `sweep`
+    if (itr == _slotblends.end()) {
+        auto oldslotblends = get_oldslotblends(scope);
+        auto itrOld = oldslotblends.require_find(blenderid, "Burner ID does not exist!");
+
+        check(isAuthorized(itrOld->collection, user), "User is not authorized in this collection!");
+
+        oldslotblends.erase(itrOld);
+        remove_blend_state(blenderid, scope);
+        return;
+    }
 
     // check if user is authorized in collection
     check(isAuthorized(itr->collection, user), "User is not authorized in this collection!");
 
+    // release the shared ingredients and targets
+    release_slotspec(scope, itr->specid);
+    release_targetspec(scope, itr->poolid);
+
     // remove item
     _slotblends.erase(itr);
 
-    // remove blend config if it exists
-    remove_blend_config(blenderid, user, scope);
+    // remove blend config and stats if it exists
+    remove_blend_state(blenderid, scope);
+}
 
-    // remove blend stats if it exists
-    remove_blend_stats(blenderid, user, scope);
-}
\ No newline at end of file
+/**
+ * Remove a hash Slot Blend.
+ * User should be authorized by the collection blender.
+*/
+ACTION shomaiiblend::remblhash(name user, name scope, uint64_t blenderid) {
+    require_auth(user);
+    blockContract(user);
+
+    auto _hashblends = get_hashblends(scope);
+    auto itr = _hashblends.require_find(blenderid, "Burner ID does not exist!");
+
+    // check if user is authorized in collection
+    check(isAuthorized(itr->collection, user), "User is not authorized in this collection!");
+
+    // release the shared targets
+    release_targetspec(scope, itr->poolid);
+
+    // remove item
+    _hashblends.erase(itr);
+
+    // remove blend config and stats if it exists
+    remove_blend_state(blenderid, scope);
+}
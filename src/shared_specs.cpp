@@ -0,0 +1,135 @@
+#include <shomaiiblend.hpp>
+
+/**
+ * Key of the shared spec, the first 8 bytes of its content hash.
+*/
+uint64_t shomaiiblend::content_key(const checksum256 &hash) {
+    auto bytes = hash.extract_as_byte_array();
+
+    uint64_t key;
+    memcpy(&key, bytes.data(), sizeof(key));
+    return key;
+}
+
+/**
+ * Returns the spec of the slot ingredients and adds a reference to it.
+ * The ingredients are only validated and compiled if no blend of the collection has the same ingredients yet.
+*/
+uint64_t shomaiiblend::acquire_slotspec(name collection, name payer, const vector<SlotBlendIngredient> &ingredients) {
+    auto packed = pack(ingredients);
+    checksum256 hash = sha256(packed.data(), packed.size());
+    uint64_t specid = content_key(hash);
+
+    auto slotspecs = get_slotspecs(collection);
+    auto itr = slotspecs.find(specid);
+
+    if (itr != slotspecs.end()) {
+        check(itr->hash == hash, "Ingredients collide with another spec, please reorder the ingredients.");
+
+        // only check the templates that were created after it was last refreshed
+        slotspecs.modify(itr, payer, [&](slotspec_s &row) {
+            row.refs++;
+            refresh_program(row.program, MAX_TEMPLATE_SCAN);
+        });
+
+        return specid;
+    }
+
+    // validate and compile the ingredients, the first templates of the attribute slots are checked now
+    SlotProgram program;
+    program.template_counter = 0;
+    for (const auto &i : ingredients) {
+        compile_slot(i, program);
+    }
+    refresh_program(program, MAX_TEMPLATE_SCAN);
+
+    slotspecs.emplace(payer, [&](slotspec_s &row) {
+        row.specid = specid;
+        row.hash = hash;
+        row.refs = 1;
+
+        row.ingredients = ingredients;
+        row.program = program;
+    });
+
+    return specid;
+}
+
+/**
+ * Removes a reference to the spec, the spec is erased when it has no more references.
+*/
+void shomaiiblend::release_slotspec(name collection, uint64_t specid) {
+    auto slotspecs = get_slotspecs(collection);
+    auto itr = slotspecs.require_find(specid, "Slot spec does not exist!");
+
+    if (itr->refs <= 1) {
+        slotspecs.erase(itr);
+        return;
+    }
+
+    slotspecs.modify(itr, same_payer, [&](slotspec_s &row) {
+        row.refs--;
+    });
+}
+
+/**
+ * Returns the pool of the targets and adds a reference to it.
+ * The targets should already be validated.
+*/
+uint64_t shomaiiblend::acquire_targetspec(name collection, name payer, const vector<MultiTarget> &targets) {
+    auto packed = pack(targets);
+    checksum256 hash = sha256(packed.data(), packed.size());
+    uint64_t poolid = content_key(hash);
+
+    auto targetspecs = get_targetspecs(collection);
+    auto itr = targetspecs.find(poolid);
+
+    if (itr != targetspecs.end()) {
+        check(itr->hash == hash, "Targets collide with another pool, please reorder the targets.");
+
+        targetspecs.modify(itr, same_payer, [&](targetspec_s &row) {
+            row.refs++;
+        });
+
+        return poolid;
+    }
+
+    targetspecs.emplace(payer, [&](targetspec_s &row) {
+        row.poolid = poolid;
+        row.hash = hash;
+        row.refs = 1;
+
+        row.targets = targets;
+    });
+
+    return poolid;
+}
+
+/**
+ * Adds a reference to an existing pool, used by the pending claim jobs.
+*/
+void shomaiiblend::retain_targetspec(name collection, uint64_t poolid) {
+    auto targetspecs = get_targetspecs(collection);
+    auto itr = targetspecs.require_find(poolid, "Blender's target pool does not exist.");
+
+    targetspecs.modify(itr, same_payer, [&](targetspec_s &row) {
+        row.refs++;
+    });
+}
+
+/**
+ * Removes a reference to the pool, the pool is erased when it has no more references.
+*/
+void shomaiiblend::release_targetspec(name collection, uint64_t poolid) {
+    auto targetspecs = get_targetspecs(collection);
+    auto itr = targetspecs.require_find(poolid, "Blender's target pool does not exist.");
+
+    if (itr->refs <= 1) {
+        targetspecs.erase(itr);
+        return;
+    }
+
+    targetspecs.modify(itr, same_payer, [&](targetspec_s &row) {
+        row.refs--;
+    });
+}
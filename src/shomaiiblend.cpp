@@ -7,6 +7,8 @@
 #include "make_blend.cpp"
 #include "ram_balance.cpp"
 #include "remove_blend.cpp"
+#include "shared_specs.cpp"
+#include "sweep.cpp"
 
 /**
  * Initialize main config singleton db.
@@ -18,12 +20,23 @@ ACTION shomaiiblend::init() {
 }
 
 /**
- * Initialize system config singleton db.
+ * Move the whitelists and blacklists of the old system config singleton to the services table.
 */
-ACTION shomaiiblend::initsys() {
+ACTION shomaiiblend::sysmigrate() {
     require_auth(get_self());
 
-    sysconfig.get_or_create(_self, sysconfig_s{});
+    check(sysconfig.exists(), "There is no system config to migrate.");
+
+    auto _sysconfig = sysconfig.get();
+
+    for (auto i : _sysconfig.whitelists) {
+        set_service(i, true, isBlacklisted(i));
+    }
+    for (auto i : _sysconfig.blacklists) {
+        set_service(i, isWhitelisted(i), true);
+    }
+
+    sysconfig.remove();
 }
 
 /**
@@ -35,14 +48,8 @@ ACTION shomaiiblend::sysaddwhite(name collection) {
     // require check if collection exists or not
     atomicassets::collections.require_find(collection.value, "Collection does not exist!");
 
-    auto _sysconfig = sysconfig.get();
-
-    if (find(_sysconfig.whitelists.begin(), _sysconfig.whitelists.end(), collection) == _sysconfig.whitelists.end()) {
-        // if collection does not exist, push it to the vector
-        _sysconfig.whitelists.push_back(collection);
-
-        // set new whitelist collections
-        sysconfig.set(_sysconfig, get_self());
+    if (!isWhitelisted(collection)) {
+        set_service(collection, true, isBlacklisted(collection));
     }
 }
 
@@ -55,15 +62,25 @@ ACTION shomaiiblend::sysaddblack(name collection) {
     // require check if collection exists or not
     atomicassets::collections.require_find(collection.value, "Collection does not exist!");
 
-    auto _sysconfig = sysconfig.get();
+    if (!isBlacklisted(collection)) {
+        set_service(collection, isWhitelisted(collection), true);
+    }
+}
 
-    if (find(_sysconfig.blacklists.begin(), _sysconfig.blacklists.end(), collection) == _sysconfig.blacklists.end()) {
-        // if collection does not exist, push it to the vector
-        _sysconfig.blacklists.push_back(collection);
+/**
+ * Set if the collection only accepts its own assets when transferred for its blends.
+*/
+ACTION shomaiiblend::setstrictdep(name author, name collection, bool strict) {
+    require_auth(author);
+    blockContract(author);
 
-        // set new whitelist collections
-        sysconfig.set(_sysconfig, get_self());
-    }
+    check(isAuthorized(collection, author), "User is not authorized in collection!");
+
+    auto itr = services.require_find(collection.value, "Collection is not registered in the service!");
+
+    services.modify(itr, get_self(), [&](service_s &row) {
+        row.strict_deposits = strict;
+    });
 }
 
 /**
@@ -75,20 +92,41 @@ ACTION shomaiiblend::sysaddblack(name collection) {
         return;
     }
 
+    // nfts taken by the custody-free blends are burned or locked in the same action, nothing to save for refund
+    if (memo == CUSTODYFREE_MEMO) {
+        receivetake(from, asset_ids);
+        return;
+    }
+
+    // blend right away, nothing to save for refund
+    if (memo.rfind(BLEND_MEMO_PREFIX, 0) == 0) {
+        blendfrommemo(from, asset_ids, memo);
+        return;
+    }
+
     // check collection name
     check(memo.size() == 12, "Collection name in memo is too long!");
 
     name col = name(memo);
-    nftrefund_t refundtable = get_nftrefunds(from);
+    deposit_t deposits = get_deposits(from);
 
-    // save all nfts
+    bool strict = isStrictDeposits(col);
+
+    // save the info of all nfts, so the blends do not need to read them again
+    auto assets = atomicassets::get_assets(get_self());
+    vector<DepositAsset> deposited = {};
+    deposited.reserve(asset_ids.size());
     for (auto i : asset_ids) {
-        refundtable.emplace(get_self(), [&](nftrefund_s &row) {
-            row.assetid = i;
-            row.collection = col;
-            row.from = from;
-        });
+        auto itr = assets.require_find(i, "Transferred asset does not exist!");
+
+        if (strict) {
+            check(itr->collection_name == col, "Asset is not from the collection!");
+        }
+
+        deposited.push_back(DepositAsset{i, itr->collection_name, itr->schema_name, itr->template_id});
     }
+
+    addDeposits(deposits, col, deposited);
 }
 
 /**
@@ -99,14 +137,12 @@ ACTION shomaiiblend::refundnfts(name user, name scope, vector<uint64_t> assetids
     require_auth(user);
     blockContract(user);
 
-    auto refundtable = get_nftrefunds(user);
+    auto deposits = get_deposits(user);
+    auto itr = deposits.require_find(scope.value, "User has no assets for refund in the collection!");
 
     // check all assets and confirm
     for (auto i : assetids) {
-        auto itr = refundtable.require_find(i, "Asset does not exist in collection for refund!");
-
-        check(itr->collection == scope, "Asset's collection is not similar to scope!");  // useless check
-        check(itr->from == user, "Asset is not from user!");
+        check(findDeposit(itr->assets, i) != itr->assets.end(), "Asset does not exist in collection for refund!");
     }
 
     // transfer NFTs
@@ -117,6 +153,37 @@ ACTION shomaiiblend::refundnfts(name user, name scope, vector<uint64_t> assetids
         make_tuple(get_self(), user, assetids, string("nft refund from shomai blends")))
         .send();
 
-    // remove from refunds
-    removeRefundNFTs(user, scope, assetids);
+    // remove from deposits
+    removeRefundNFTs(deposits, itr, assetids);
+}
+
+/**
+ * Move the user's assets from the old refund table to the deposit ledger.
+ * At most `limit` assets are moved from the `cursor` asset id, call again for the rest.
+*/
+ACTION shomaiiblend::migrefunds(name user, uint64_t cursor, uint32_t limit) {
+    require_auth(user);
+    blockContract(user);
+
+    check(limit > 0 && limit <= MAX_SWEEP_LIMIT, "Limit should be between 1 and " + to_string(MAX_SWEEP_LIMIT) + ".");
+
+    auto refundtable = get_nftrefunds(user);
+    auto deposits = get_deposits(user);
+
+    auto itr = refundtable.lower_bound(cursor);
+    check(itr != refundtable.end(), "User has no assets in the old refund table.");
+
+    auto assets = atomicassets::get_assets(get_self());
+
+    map<name, vector<DepositAsset>> collections = {};
+    for (; itr != refundtable.end() && limit > 0; limit--) {
+        auto itrAsset = assets.require_find(itr->assetid, "Asset does not exist in the smart contract!");
+        collections[itr->collection].push_back(DepositAsset{itr->assetid, itrAsset->collection_name, itrAsset->schema_name, itrAsset->template_id});
+
+        itr = refundtable.erase(itr);
+    }
+
+    for (const auto &i : collections) {
+        addDeposits(deposits, i.first, i.second);
+    }
 }
\ No newline at end of file
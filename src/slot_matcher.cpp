@@ -0,0 +1,78 @@
+#include <shomaiiblend.hpp>
+
+/**
+ * Assigns the assets of a slot blend call to the blend's slots, regardless of the order the assets were sent.
+ * Each slot can hold up to its `amount` of assets and an asset can only be assigned to the slots it is a candidate of.
+ *
+ * The most selective assets (fewest candidate slots) are assigned first and conflicts are resolved with
+ * augmenting paths (Kuhn's algorithm), so an assignment is always found if one exists.
+*/
+class SlotMatcher {
+   public:
+    SlotMatcher(const vector<SlotPredicate> &slots, size_t asset_count) {
+        capacities.reserve(slots.size());
+        for (const auto &i : slots) {
+            capacities.push_back(i.amount);
+        }
+
+        candidates.resize(asset_count);
+        assigned.resize(slots.size());
+    }
+
+    void add_candidate(size_t asset, size_t slot) {
+        candidates[asset].push_back(slot);
+    }
+
+    bool match() {
+        vector<size_t> order(candidates.size());
+        for (size_t i = 0; i < order.size(); i++) {
+            order[i] = i;
+        }
+
+        sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return candidates[a].size() < candidates[b].size();
+        });
+
+        vector<bool> visited(capacities.size());
+        for (auto i : order) {
+            // an asset without any candidate slot can never be matched
+            if (candidates[i].size() == 0) return false;
+
+            fill(visited.begin(), visited.end(), false);
+            if (!assign(i, visited)) return false;
+        }
+
+        return true;
+    }
+
+   private:
+    bool assign(size_t asset, vector<bool> &visited) {
+        // take a free spot first
+        for (auto s : candidates[asset]) {
+            if (!visited[s] && assigned[s].size() < capacities[s]) {
+                visited[s] = true;
+                assigned[s].push_back(asset);
+                return true;
+            }
+        }
+
+        // otherwise, try to move one of the assigned assets to another slot
+        for (auto s : candidates[asset]) {
+            if (visited[s]) continue;
+            visited[s] = true;
+
+            for (auto &other : assigned[s]) {
+                if (assign(other, visited)) {
+                    other = asset;
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    vector<uint32_t> capacities;
+    vector<vector<size_t>> candidates;  // candidate slots of each asset
+    vector<vector<size_t>> assigned;    // assigned assets of each slot
+};
@@ -0,0 +1,285 @@
+#include <shomaiiblend.hpp>
+
+/**
+ * Reclaims the stale rows of a table, starting from the `cursor` primary key and checking at most `limit` rows.
+ * Anyone can call this, only the rows that are no longer used are removed.
+ *
+ * Tables and their scopes:
+ *  - `deposits` (user), ledgers that were not used for DEPOSIT_EXPIRY are refunded to the user.
+ *  - `nftrefunds` (user), the deprecated refunds are sent back to the user.
+ *  - `blenduses` (user), usage rows of the `collection`'s blends that no longer limit the user.
+ *  - `blendcfuses` (user), usage rows saved before the compact layout that no longer limit the user, same as `blenduses`.
+ *    These rows do not know their collection, so the rows of removed blends are only removed if the author of `collection` signs.
+ *  - `targetpools` (collection), the deprecated pools when no old claim job or old slot blend needs them anymore.
+ *  - `simblenders`, `simswaps`, `slotblends`, `slotblenders` and `hashblends` (collection), blends that ended ENDED_BLEND_GRACE ago.
+ *  - `blendconfig` (collection), the configs saved before the blend states are moved to `blendstates` and their names to `blendwhlists`,
+ *    a config with more names than `limit` is moved over several calls from its blenderid.
+ *  - `blendstats` (collection), the stats saved before the blend states are moved to `blendstates`.
+*/
+ACTION shomaiiblend::sweep(name table, name scope, name collection, uint64_t cursor, uint32_t limit) {
+    check(limit > 0 && limit <= MAX_SWEEP_LIMIT, "Limit should be between 1 and " + to_string(MAX_SWEEP_LIMIT) + ".");
+
+    if (table == name("deposits")) {
+        sweep_deposits(scope, cursor, limit);
+    } else if (table == name("nftrefunds")) {
+        sweep_nftrefunds(scope, cursor, limit);
+    } else if (table == name("blenduses")) {
+        sweep_userblends(scope, collection, cursor, limit);
+    } else if (table == name("blendcfuses")) {
+        sweep_olduserblends(scope, collection, cursor, limit);
+    } else if (table == name("targetpools")) {
+        sweep_targetpools(scope, cursor, limit);
+    } else if (table == name("simblenders")) {
+        auto _simpleblends = get_simpleblends(scope);
+        sweep_ended_blends(_simpleblends, scope, cursor, limit, [](const simpleblend_s &) {});
+    } else if (table == name("simswaps")) {
+        auto _simpleswaps = get_simpleswaps(scope);
+        sweep_ended_blends(_simpleswaps, scope, cursor, limit, [](const simpleswap_s &) {});
+    } else if (table == name("slotblends")) {
+        auto _slotblends = get_slotblends(scope);
+        sweep_ended_blends(_slotblends, scope, cursor, limit, [&](const slotblend_s &row) {
+            release_slotspec(scope, row.specid);
+            release_targetspec(scope, row.poolid);
+        });
+    } else if (table == name("slotblenders")) {
+        // the old target pools are removed with `targetpools`
+        auto oldslotblends = get_oldslotblends(scope);
+        sweep_ended_blends(oldslotblends, scope, cursor, limit, [](const oldslotblend_s &) {});
+    } else if (table == name("hashblends")) {
+        auto _hashblends = get_hashblends(scope);
+        sweep_ended_blends(_hashblends, scope, cursor, limit, [&](const hashblend_s &row) {
+            release_targetspec(scope, row.poolid);
+        });
+    } else if (table == name("blendconfig")) {
+        sweep_oldblendconfigs(scope, cursor, limit);
+    } else if (table == name("blendstats")) {
+        sweep_oldblendstats(scope, cursor, limit);
+    } else {
+        check(false, "Table cannot be swept!");
+    }
+}
+
+/**
+ * Refunds the deposit ledgers of the user that were not used for DEPOSIT_EXPIRY, the freed ram stays with the smart contract.
+*/
+void shomaiiblend::sweep_deposits(name user, uint64_t cursor, uint32_t &limit) {
+    auto deposits = get_deposits(user);
+
+    for (auto itr = deposits.lower_bound(cursor); itr != deposits.end() && limit > 0; limit--) {
+        int64_t last_deposit = BLEND_EPOCH + itr->last_deposit.value;
+        if (now() - last_deposit <= DEPOSIT_EXPIRY) {
+            itr++;
+            continue;
+        }
+
+        vector<uint64_t> assetids = {};
+        assetids.reserve(itr->assets.size());
+        for (const auto &i : itr->assets) {
+            assetids.push_back(i.asset_id);
+        }
+
+        action(
+            permission_level{get_self(), name("active")},
+            ATOMICASSETS,
+            name("transfer"),
+            make_tuple(get_self(), user, assetids, string("expired deposit refund from shomai blends")))
+            .send();
+
+        itr = deposits.erase(itr);
+    }
+}
+
+/**
+ * Sends the assets of the deprecated refund table back to the user.
+ * These rows were never charged to a collection, so the freed ram stays with the smart contract.
+*/
+void shomaiiblend::sweep_nftrefunds(name user, uint64_t cursor, uint32_t &limit) {
+    auto refundtable = get_nftrefunds(user);
+
+    vector<uint64_t> assetids = {};
+    for (auto itr = refundtable.lower_bound(cursor); itr != refundtable.end() && limit > 0; limit--) {
+        assetids.push_back(itr->assetid);
+        itr = refundtable.erase(itr);
+    }
+
+    if (assetids.size() == 0) return;
+
+    action(
+        permission_level{get_self(), name("active")},
+        ATOMICASSETS,
+        name("transfer"),
+        make_tuple(get_self(), user, assetids, string("nft refund from shomai blends")))
+        .send();
+}
+
+/**
+ * Removes the usage rows of the user on the collection's blends that no longer limit the user,
+ * the blend was removed, has ended or its cooldown has passed without a max user use.
+ * Rows charged to other collections are skipped, the freed ram is credited to the collection.
+*/
+void shomaiiblend::sweep_userblends(name user, name collection, uint64_t cursor, uint32_t &limit) {
+    auto _blenduses = get_userblends(user);
+    auto _blendstates = get_blendstates(collection);
+
+    for (auto itr = _blenduses.lower_bound(cursor); itr != _blenduses.end() && limit > 0; limit--) {
+        if (itr->collection != collection) {
+            itr++;
+            continue;
+        }
+
+        bool stale = !blend_exists(itr->blenderid, collection);
+        if (!stale) {
+            migrateblendstate(itr->blenderid, collection);
+
+            auto itrState = _blendstates.find(itr->blenderid);
+            BlendConfig blendconfig = load_blend_config(_blendstates, itrState);
+
+            bool cooled = blendconfig.maxusercooldown == -1 || now() - (BLEND_EPOCH + itr->last_used) > blendconfig.maxusercooldown;
+            stale = (cooled && blendconfig.maxuseruse == -1) || is_blend_ended(collection, itr->blenderid);
+        }
+
+        if (!stale) {
+            itr++;
+            continue;
+        }
+
+        itr = erase_charged(_blenduses, itr, collection);
+    }
+}
+
+/**
+ * Removes the usage rows saved before the compact layout that no longer limit the user, same as `blenduses`.
+ * The rows that still limit the user are kept, they are moved when the user calls the blend.
+ * The rows of blends that are not in the collection are only removed if signed by the collection's author,
+ * the author vouches for the removed blends since the row cannot tell which collection it was from.
+*/
+void shomaiiblend::sweep_olduserblends(name user, name collection, uint64_t cursor, uint32_t &limit) {
+    auto olduses = get_olduserblends(user);
+    auto _blendstates = get_blendstates(collection);
+
+    bool author = has_auth(atomiccache.collection(collection)->author);
+
+    for (auto itr = olduses.lower_bound(cursor); itr != olduses.end() && limit > 0; limit--) {
+        if (!blend_exists(itr->blenderid, collection)) {
+            if (author) {
+                itr = olduses.erase(itr);
+            } else {
+                itr++;
+            }
+            continue;
+        }
+
+        migrateblendstate(itr->blenderid, collection);
+
+        auto itrState = _blendstates.find(itr->blenderid);
+        BlendConfig blendconfig = load_blend_config(_blendstates, itrState);
+
+        bool cooled = blendconfig.maxusercooldown == -1 || now() - itr->last_used > blendconfig.maxusercooldown;
+        bool stale = (cooled && blendconfig.maxuseruse == -1) || is_blend_ended(collection, itr->blenderid);
+
+        if (!stale) {
+            itr++;
+            continue;
+        }
+
+        itr = olduses.erase(itr);
+    }
+}
+
+/**
+ * Removes the deprecated target pools, these are only needed by the old claim jobs and the slot blends that are not migrated yet.
+*/
+void shomaiiblend::sweep_targetpools(name collection, uint64_t cursor, uint32_t &limit) {
+    check(oldclaimjobs.begin() == oldclaimjobs.end(), "The old claim jobs still need the target pools.");
+
+    auto oldtargets = get_blendertargets(collection);
+    auto oldslotblends = get_oldslotblends(collection);
+
+    for (auto itr = oldtargets.lower_bound(cursor); itr != oldtargets.end() && limit > 0; limit--) {
+        if (oldslotblends.find(itr->blenderid) != oldslotblends.end()) {
+            itr++;
+            continue;
+        }
+
+        itr = oldtargets.erase(itr);
+    }
+}
+
+/**
+ * Moves the configs saved before the blend states, each whitelisted name counts against the limit.
+ * The sweep stops on a config whose names are not all moved, so it can be called again from its blenderid.
+*/
+void shomaiiblend::sweep_oldblendconfigs(name collection, uint64_t cursor, uint32_t &limit) {
+    auto oldconfigs = get_oldblendconfigs(collection);
+
+    for (auto itr = oldconfigs.lower_bound(cursor); itr != oldconfigs.end() && limit > 0;) {
+        uint64_t blenderid = itr->blenderid;
+        itr++;
+        limit--;
+
+        migrateblendstate(blenderid, collection);
+        if (!move_legacy_whitelist(blenderid, collection, limit)) break;
+    }
+}
+
+/**
+ * Moves the stats saved before the blend states, each row is moved with its config.
+*/
+void shomaiiblend::sweep_oldblendstats(name collection, uint64_t cursor, uint32_t &limit) {
+    auto oldstats = get_oldblendstats(collection);
+
+    for (auto itr = oldstats.lower_bound(cursor); itr != oldstats.end() && limit > 0; limit--) {
+        uint64_t blenderid = itr->blenderid;
+        itr++;
+
+        migrateblendstate(blenderid, collection);
+    }
+}
+
+/**
+ * Removes the blends that ended ENDED_BLEND_GRACE ago with their whitelist and state.
+ * The whitelist rows are part of the limit, so a blend with a big whitelist is removed after a few calls.
+*/
+template <typename Table, typename Release>
+void shomaiiblend::sweep_ended_blends(Table &blends, name scope, uint64_t cursor, uint32_t &limit, Release release) {
+    for (auto itr = blends.lower_bound(cursor); itr != blends.end() && limit > 0;) {
+        limit--;
+
+        if (!is_blend_ended(scope, itr->blenderid) || !sweep_blend_whitelist(itr->blenderid, scope, limit)) {
+            itr++;
+            continue;
+        }
+
+        release(*itr);
+        remove_blend_state(itr->blenderid, scope);
+
+        itr = blends.erase(itr);
+    }
+}
+
+/**
+ * Removes the whitelist rows of the blend within the limit, returns true if the whitelist is now empty.
+*/
+bool shomaiiblend::sweep_blend_whitelist(uint64_t blenderid, name scope, uint32_t &limit) {
+    auto _whitelists = get_blendwhitelists(blenderid);
+
+    auto itr = _whitelists.begin();
+    for (; itr != _whitelists.end() && limit > 0; limit--) {
+        itr = erase_charged(_whitelists, itr, scope);
+    }
+
+    return itr == _whitelists.end();
+}
+
+/**
+ * Checks if the blend's end date was ENDED_BLEND_GRACE ago.
+*/
+bool shomaiiblend::is_blend_ended(name scope, uint64_t blenderid) {
+    // the config saved before the blend states is read from its state
+    migrateblendstate(blenderid, scope);
+
+    auto _blendstates = get_blendstates(scope);
+    BlendConfig blendconfig = load_blend_config(_blendstates, _blendstates.find(blenderid));
+
+    return blendconfig.enddate != -1 && int64_t(now()) > int64_t(blendconfig.enddate) + ENDED_BLEND_GRACE;
+}